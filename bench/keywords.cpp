@@ -0,0 +1,145 @@
+// Keyword lookup: the perfect hash from keywords.hpp against the switch trie
+// the lexer used before it.
+// Build: g++ -std=c++20 -O2 -Isrc bench/keywords.cpp -o keywords
+#include "AST-generation/tokens/keywords.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+static TokenType checkKeyword(std::string_view lexeme, int startIndex,
+                              std::string_view restOfKeyword,
+                              TokenType typeIfMatch) {
+  if (lexeme.substr(startIndex) != restOfKeyword) {
+    return TokenType::Identifier;
+  }
+
+  return typeIfMatch;
+}
+
+static TokenType trie(std::string_view lexeme) {
+  size_t len = lexeme.size();
+  switch (lexeme[0]) {
+  case 'b':
+    return checkKeyword(lexeme, 1, "reak", TokenType::Break);
+  case 'c':
+    if (len > 1) {
+      switch (lexeme[1]) {
+      case 'l':
+        return checkKeyword(lexeme, 2, "ass", TokenType::Class);
+      case 'o':
+        return checkKeyword(lexeme, 2, "ntinue", TokenType::Continue);
+      }
+    }
+
+    break;
+  case 'e':
+    return checkKeyword(lexeme, 1, "lse", TokenType::Else);
+  case 'f':
+    if (len > 1) {
+      switch (lexeme[1]) {
+      case 'a':
+        return checkKeyword(lexeme, 2, "lse", TokenType::False);
+      case 'o':
+        return checkKeyword(lexeme, 2, "r", TokenType::For);
+      case 'n':
+        return checkKeyword(lexeme, 2, "", TokenType::Fn);
+      }
+    }
+
+    break;
+  case 'i':
+    if (len > 1) {
+      switch (lexeme[1]) {
+      case 'f':
+        return checkKeyword(lexeme, 2, "", TokenType::If);
+      case 'm':
+        return checkKeyword(lexeme, 2, "port", TokenType::Import);
+      }
+    }
+
+    break;
+  case 'l':
+    if (len > 1) {
+      switch (lexeme[1]) {
+      case 'e':
+        return checkKeyword(lexeme, 2, "t", TokenType::Let);
+      case 'o':
+        return checkKeyword(lexeme, 2, "op", TokenType::Loop);
+      }
+    }
+    break;
+  case 'n':
+    return checkKeyword(lexeme, 1, "il", TokenType::Nil);
+  case 'r':
+    return checkKeyword(lexeme, 1, "eturn", TokenType::Return);
+  case 's':
+    return checkKeyword(lexeme, 1, "uper", TokenType::Super);
+  case 't':
+    if (len > 1) {
+      switch (lexeme[1]) {
+      case 'r':
+        return checkKeyword(lexeme, 2, "ue", TokenType::True);
+      case 'h':
+        return checkKeyword(lexeme, 2, "is", TokenType::This);
+      }
+    }
+    break;
+  case 'w':
+    return checkKeyword(lexeme, 1, "hile", TokenType::While);
+  }
+
+  return TokenType::Identifier;
+}
+
+template <typename Lookup>
+static double run(const std::vector<std::string_view> &words, Lookup lookup,
+                  size_t &keywords) {
+  double best = 1e9;
+
+  for (int run = 0; run < 5; run++) {
+    keywords = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200000; i++) {
+      for (std::string_view word : words) {
+        keywords += lookup(word) != TokenType::Identifier;
+      }
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    best = std::min(best, elapsed.count() / (200000.0 * words.size()));
+  }
+
+  return best;
+}
+
+int main() {
+  // Keywords, the identifiers found around them and words that share a
+  // prefix or a length with a keyword.
+  std::vector<std::string_view> words = {
+      "let", "fn", "return", "if", "else", "while", "for", "class", "this",
+      "super", "true", "false", "nil", "break", "continue", "loop", "import",
+      "i", "n", "x", "fib", "count", "println", "clock", "value", "left",
+      "right", "node", "total", "lets", "fnord", "iffy", "elsewhere", "classy",
+      "thus", "nile", "breaker", "continues", "importance", "fo", "whilst",
+      "a_long_identifier",
+  };
+
+  for (std::string_view word : words) {
+    if (trie(word) != Keywords::find(word)) {
+      std::cerr << "mismatch on `" << word << "`" << std::endl;
+      return 1;
+    }
+  }
+
+  size_t trieKeywords, hashKeywords;
+  double trieTime = run(words, trie, trieKeywords);
+  double hashTime = run(words, Keywords::find, hashKeywords);
+
+  std::cout << "trie:         " << trieTime << " ns/word (" << trieKeywords
+            << ")\n"
+            << "perfect hash: " << hashTime << " ns/word (" << hashKeywords
+            << ")" << std::endl;
+}
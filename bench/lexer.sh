@@ -0,0 +1,30 @@
+#!/bin/sh
+# Lexer throughput with every set of scanning kernels the CPU supports, on two
+# large files: the other benchmarks repeated, where most of the time goes into
+# making tokens, and long comments, strings and identifiers, where it goes
+# into the kernels.
+# Usage: bench/lexer.sh path/to/lbpl [copies]
+set -e
+
+dir=$(dirname "$0")
+dense=$(mktemp --suffix=.lbpl)
+runs=$(mktemp --suffix=.lbpl)
+trap 'rm -f "$dense" "$runs"' EXIT
+
+for i in $(seq "${2:-2000}"); do
+  cat "$dir"/*.lbpl
+done >"$dense"
+
+awk -v copies="${2:-2000}" 'BEGIN {
+  text = "the lexer goes through comments, strings and names a block at a time"
+  for (i = 0; i < 10 * copies; i++) {
+    print "# " text ", " text
+    print "let message_" i " = \"" text ", " text "\";"
+    print "let a_rather_long_and_descriptive_name_" i " = message_" i ";"
+  }
+}' >"$runs"
+
+echo "Dense code:"
+"$1" --lex-bench "$dense"
+echo "Long comments, strings and identifiers:"
+"$1" --lex-bench "$runs"
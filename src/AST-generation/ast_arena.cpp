@@ -0,0 +1,29 @@
+#include "ast_arena.hpp"
+
+AstArena::~AstArena() {
+  for (auto it = destructors.rbegin(); it != destructors.rend(); it++) {
+    it->destroy(it->object);
+  }
+}
+
+void *AstArena::allocate(size_t size, size_t alignment) {
+  size_t offset = (used + alignment - 1) & ~(alignment - 1);
+
+  if (offset + size > BLOCK_SIZE) {
+    // Long lists get a block of their own, put behind the current one so
+    // that it keeps being filled.
+    if (size > BLOCK_SIZE / 4) {
+      auto block = std::make_unique_for_overwrite<std::byte[]>(size);
+      std::byte *memory = block.get();
+      blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1,
+                    std::move(block));
+      return memory;
+    }
+
+    blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(BLOCK_SIZE));
+    offset = 0;
+  }
+
+  used = offset + size;
+  return blocks.back().get() + offset;
+}
@@ -0,0 +1,60 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator the parser builds the AST of a file in. Nodes end up next to
+// each other in the order they are parsed and are all freed at once with the
+// arena, none of them is ever freed on its own.
+class AstArena {
+private:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  struct Destructor {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  size_t used;
+  // Nodes that own memory of their own, destroyed with the arena.
+  std::vector<Destructor> destructors;
+
+  void *allocate(size_t size, size_t alignment);
+
+public:
+  AstArena() : blocks(), used(BLOCK_SIZE), destructors() {}
+  AstArena(const AstArena &) = delete;
+  ~AstArena();
+
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    T *object = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors.push_back(
+          {object, [](void *object) { static_cast<T *>(object)->~T(); }});
+    }
+    return object;
+  }
+
+  // Copies a list the parser collected into the arena.
+  template <typename T> std::span<T> copy(const std::vector<T> &list) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (list.empty()) {
+      return {};
+    }
+
+    T *items = static_cast<T *>(allocate(sizeof(T) * list.size(), alignof(T)));
+    std::uninitialized_copy(list.begin(), list.end(), items);
+    return {items, list.size()};
+  }
+};
+
+#endif
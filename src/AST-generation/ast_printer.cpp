@@ -0,0 +1,219 @@
+#include "ast_printer.hpp"
+
+#include <iomanip>
+#include <string>
+
+void AstPrinter::print(std::span<Stmt *> stmts) {
+  for (auto &&stmt : stmts) {
+    print(stmt);
+    os << '\n';
+  }
+}
+
+void AstPrinter::print(Stmt *stmt) { stmt->accept(this); }
+void AstPrinter::print(Expr *expr) { expr->accept(this); }
+
+void AstPrinter::printBody(std::span<Stmt *> body) {
+  depth++;
+  for (auto &&stmt : body) {
+    os << '\n' << std::string(2 * depth, ' ');
+    print(stmt);
+  }
+  depth--;
+}
+
+void AstPrinter::visitFnStmt(FnStmt *fn) {
+  os << "(fn " << fn->name->symbol.str() << " (";
+  for (size_t i = 0; i < fn->args.size(); i++) {
+    os << (i > 0 ? " " : "") << fn->args[i]->symbol.str();
+  }
+  os << ")";
+
+  printBody(fn->body);
+  os << ")";
+}
+
+void AstPrinter::visitVarStmt(VarStmt *var) {
+  os << "(let " << var->name->symbol.str();
+  if (var->value) {
+    os << " ";
+    print(var->value);
+  }
+  os << ")";
+}
+
+void AstPrinter::visitClassStmt(ClassStmt *clas) {
+  os << "(class " << clas->name->symbol.str();
+  if (clas->superclass) {
+    os << " < " << clas->superclass->variable->symbol.str();
+  }
+
+  printBody(clas->body);
+  os << ")";
+}
+
+void AstPrinter::visitIfStmt(IfStmt *stmt) {
+  os << "(if ";
+  print(stmt->condition);
+  printBody({&stmt->trueBranch, 1});
+  if (stmt->falseBranch) {
+    printBody({&stmt->falseBranch, 1});
+  }
+  os << ")";
+}
+
+void AstPrinter::visitWhileStmt(WhileStmt *loop) {
+  os << "(while ";
+  print(loop->condition);
+  printBody({&loop->body, 1});
+  os << ")";
+}
+
+void AstPrinter::visitForStmt(ForStmt *loop) {
+  os << "(for ";
+  if (loop->initializer) {
+    print(loop->initializer);
+  } else {
+    os << "()";
+  }
+  os << " ";
+  print(loop->condition);
+  os << " ";
+  if (loop->increment) {
+    print(loop->increment);
+  } else {
+    os << "()";
+  }
+
+  printBody({&loop->body, 1});
+  os << ")";
+}
+
+void AstPrinter::visitScopedStmt(ScopedStmt *block) {
+  os << "(block";
+  printBody(block->body);
+  os << ")";
+}
+
+void AstPrinter::visitExprStmt(ExprStmt *stmt) { print(stmt->expr); }
+
+void AstPrinter::visitReturnStmt(ReturnStmt *ret) {
+  os << "(return";
+  if (ret->value) {
+    os << " ";
+    print(ret->value);
+  }
+  os << ")";
+}
+
+Value AstPrinter::visitBinaryExpr(BinaryExpr *expr) {
+  os << "(" << type2str(expr->op->type) << " ";
+  print(expr->left);
+  os << " ";
+  print(expr->right);
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitBreakExpr(BreakExpr *) {
+  os << "break";
+  return nullptr;
+}
+
+Value AstPrinter::visitContinueExpr(ContinueExpr *) {
+  os << "continue";
+  return nullptr;
+}
+
+Value AstPrinter::visitUnaryExpr(UnaryExpr *expr) {
+  os << "(" << type2str(expr->op->type) << " ";
+  print(expr->right);
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitLiteralExpr(LiteralExpr *expr) {
+  const Value &value = expr->value;
+
+  if (expr->string) {
+    os << std::quoted(expr->string->str());
+  } else if (value.isDouble()) {
+    os << value.asDouble();
+  } else if (value.isInt()) {
+    os << value.asInt();
+  } else if (value.isChar()) {
+    os << "'" << value.asChar() << "'";
+  } else if (value.isBool()) {
+    os << (value.asBool() ? "true" : "false");
+  } else {
+    os << "nil";
+  }
+  return nullptr;
+}
+
+Value AstPrinter::visitGroupExpr(GroupingExpr *expr) {
+  os << "(group ";
+  print(expr->expr);
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitSuperExpr(SuperExpr *expr) {
+  os << "super." << expr->field->symbol.str();
+  return nullptr;
+}
+
+Value AstPrinter::visitThisExpr(ThisExpr *) {
+  os << "this";
+  return nullptr;
+}
+
+Value AstPrinter::visitCallExpr(FnCallExpr *expr) {
+  os << "(call ";
+  print(expr->callee);
+  for (auto &&arg : expr->args) {
+    os << " ";
+    print(arg);
+  }
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitGetFieldExpr(GetFieldExpr *expr) {
+  os << "(. ";
+  print(expr->instance);
+  os << " " << expr->field->symbol.str() << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitSetFieldExpr(SetFieldExpr *expr) {
+  os << "(= (. ";
+  print(expr->instance);
+  os << " " << expr->field->symbol.str() << ") ";
+  print(expr->value);
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitTernaryExpr(TernaryExpr *expr) {
+  os << "(? ";
+  print(expr->condition);
+  os << " ";
+  print(expr->trueBranch);
+  os << " ";
+  print(expr->falseBranch);
+  os << ")";
+  return nullptr;
+}
+
+Value AstPrinter::visitVarExpr(VariableExpr *expr) {
+  os << expr->variable->symbol.str();
+  return nullptr;
+}
+
+Value AstPrinter::visitAssignExpr(AssignExpr *expr) {
+  os << "(= " << expr->variable->symbol.str() << " ";
+  print(expr->value);
+  os << ")";
+  return nullptr;
+}
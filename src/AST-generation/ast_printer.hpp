@@ -0,0 +1,53 @@
+#ifndef AST_PRINTER_H
+#define AST_PRINTER_H
+
+#include "statements.hpp"
+
+#include <ostream>
+#include <span>
+
+// Prints the AST as s-expressions, one statement per line with the body of
+// functions, classes, blocks and loops indented under them.
+class AstPrinter : Statement::Visitor, Expression::Visitor {
+private:
+  std::ostream &os;
+  int depth;
+
+private:
+  void print(Stmt *);
+  void print(Expr *);
+  // The statements of a body, each on its own line one level deeper.
+  void printBody(std::span<Stmt *>);
+
+  void visitFnStmt(FnStmt *) override;
+  void visitVarStmt(VarStmt *) override;
+  void visitClassStmt(ClassStmt *) override;
+  void visitIfStmt(IfStmt *) override;
+  void visitWhileStmt(WhileStmt *) override;
+  void visitForStmt(ForStmt *) override;
+  void visitScopedStmt(ScopedStmt *) override;
+  void visitExprStmt(ExprStmt *) override;
+  void visitReturnStmt(ReturnStmt *) override;
+
+  Value visitBinaryExpr(BinaryExpr *) override;
+  Value visitBreakExpr(BreakExpr *) override;
+  Value visitContinueExpr(ContinueExpr *) override;
+  Value visitUnaryExpr(UnaryExpr *) override;
+  Value visitLiteralExpr(LiteralExpr *) override;
+  Value visitGroupExpr(GroupingExpr *) override;
+  Value visitSuperExpr(SuperExpr *) override;
+  Value visitThisExpr(ThisExpr *) override;
+  Value visitCallExpr(FnCallExpr *) override;
+  Value visitGetFieldExpr(GetFieldExpr *) override;
+  Value visitSetFieldExpr(SetFieldExpr *) override;
+  Value visitTernaryExpr(TernaryExpr *) override;
+  Value visitVarExpr(VariableExpr *) override;
+  Value visitAssignExpr(AssignExpr *) override;
+
+public:
+  AstPrinter(std::ostream &os) : os(os), depth(0) {}
+
+  void print(std::span<Stmt *>);
+};
+
+#endif
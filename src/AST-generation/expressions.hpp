@@ -3,37 +3,30 @@
 
 #include "tokens/token.hpp"
 
+#include "../interpretation/inline_cache.hpp"
 #include "../interpretation/visitor.hpp"
 
-#include <memory>
-#include <vector>
+#include <optional>
+#include <span>
 
+// Nodes are allocated in the parser's `AstArena` and point at each other
+// directly, they are never freed on their own. `location` is the token errors
+// about the node are reported at.
 struct Expr {
-  const char *file;
-  int line, column;
+  const Token *location;
 
-  Expr(int line, int column, const char *filename)
-      : line(line), column(column), file(filename) {}
+  Expr(const Token *location) : location(location) {}
 
-  virtual ~Expr() {};
   virtual Value accept(Expression::Visitor *) { return nullptr; }
 };
 
 struct BinaryExpr : public Expr {
-  std::unique_ptr<Expr> left;
-  std::unique_ptr<Expr> right;
-  std::shared_ptr<const Token> op;
-
-  BinaryExpr(int line, int column, const char *file,
-             std::unique_ptr<Expr> &left, std::unique_ptr<Expr> &right,
-             std::shared_ptr<const Token> &op)
-      : left(std::move(left)), right(std::move(right)), op(op),
-        Expr(line, column, file) {}
-  BinaryExpr(int line, int column, const char *file,
-             std::unique_ptr<Expr> &left, std::unique_ptr<Expr> &&right,
-             std::shared_ptr<const Token> &op)
-      : left(std::move(left)), right(std::move(right)), op(op),
-        Expr(line, column, file) {}
+  Expr *left;
+  Expr *right;
+  const Token *op;
+
+  BinaryExpr(const Token *location, Expr *left, Expr *right, const Token *op)
+      : Expr(location), left(left), right(right), op(op) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitBinaryExpr(this);
@@ -41,8 +34,7 @@ struct BinaryExpr : public Expr {
 };
 
 struct BreakExpr : public Expr {
-  BreakExpr(int line, int column, const char *file)
-      : Expr(line, column, file) {}
+  BreakExpr(const Token *location) : Expr(location) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitBreakExpr(this);
@@ -50,45 +42,70 @@ struct BreakExpr : public Expr {
 };
 
 struct ContinueExpr : public Expr {
-  ContinueExpr(int line, int column, const char *file)
-      : Expr(line, column, file) {}
+  ContinueExpr(const Token *location) : Expr(location) {}
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitContinueExpr(this);
   }
 };
 
 struct UnaryExpr : public Expr {
-  std::unique_ptr<Expr> right;
-  std::shared_ptr<const Token> op;
+  Expr *right;
+  const Token *op;
 
-  UnaryExpr(int line, int column, const char *file, std::unique_ptr<Expr> right,
-            std::shared_ptr<const Token> &op)
-      : right(std::move(right)), op(op), Expr(line, column, file) {}
+  UnaryExpr(const Token *location, Expr *right, const Token *op)
+      : Expr(location), right(right), op(op) {}
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitUnaryExpr(this);
   }
 };
 
+// Constants, written in the source or folded by the optimizer. Strings are
+// allocated each time they're evaluated so only their text is kept, anything
+// else is converted to a value once.
 struct LiteralExpr : public Expr {
-  std::shared_ptr<const Token> token;
-
-  LiteralExpr(int line, int column, const char *file,
-              std::shared_ptr<const Token> &literal)
-      : token(literal), Expr(line, column, file) {}
-  LiteralExpr(int line, int column, const char *file,
-              std::shared_ptr<const Token> &&literal)
-      : token(literal), Expr(line, column, file) {}
+  Value value;
+  std::optional<Symbol> string;
+
+  LiteralExpr(const Token *location, const Token *literal)
+      : Expr(location), value(), string() {
+    switch (literal->type) {
+    case TokenType::Number:
+      value = static_cast<double>(literal->number);
+      break;
+    case TokenType::Char:
+      value = literal->character;
+      break;
+    case TokenType::String:
+      string = literal->symbol;
+      break;
+    case TokenType::True:
+    case TokenType::False:
+      value = literal->type == TokenType::True;
+      break;
+    default:
+      break;
+    }
+  }
+  LiteralExpr(const Token *location, Value value)
+      : Expr(location), value(value), string() {}
+  LiteralExpr(const Token *location, Symbol string)
+      : Expr(location), value(), string(string) {}
+
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitLiteralExpr(this);
   }
 };
 
 struct SuperExpr : public Expr {
-  std::shared_ptr<const Token> field;
-
-  SuperExpr(int line, int column, const char *file,
-            std::shared_ptr<const Token> &field)
-      : field(field), Expr(line, column, file) {}
+  const Token *field;
+  // Where the superclass is, then where the instance the method is bound to
+  // is.
+  int depth, slot, upvalue;
+  int thisDepth, thisSlot, thisUpvalue;
+
+  SuperExpr(const Token *location, const Token *field)
+      : Expr(location), field(field), depth(-1), slot(-1), upvalue(-1),
+        thisDepth(-1), thisSlot(-1), thisUpvalue(-1) {}
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitSuperExpr(this);
   }
@@ -96,11 +113,11 @@ struct SuperExpr : public Expr {
 
 struct ThisExpr : public Expr {
 public:
-  std::shared_ptr<const Token> keyword;
+  const Token *keyword;
+  int depth, slot, upvalue;
 
-  ThisExpr(int line, int column, const char *file,
-           std::shared_ptr<const Token> &keyword)
-      : keyword(keyword), Expr(line, column, file) {}
+  ThisExpr(const Token *location, const Token *keyword)
+      : Expr(location), keyword(keyword), depth(-1), slot(-1), upvalue(-1) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitThisExpr(this);
@@ -108,35 +125,38 @@ public:
 };
 
 struct GroupingExpr : public Expr {
-  std::unique_ptr<Expr> expr;
+  Expr *expr;
 
-  GroupingExpr(int line, int column, const char *file,
-               std::unique_ptr<Expr> &expr)
-      : expr(std::move(expr)), Expr(line, column, file) {}
+  GroupingExpr(const Token *location, Expr *expr)
+      : Expr(location), expr(expr) {}
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitGroupExpr(this);
   }
 };
 
+// `depth` and `slot` are filled in by the resolver, a depth of -1 means the
+// variable is a global and has to be looked up by name. Variables of an
+// enclosing function are accessed through the closure's upvalue `upvalue`
+// instead, it's -1 for everything else.
 struct VariableExpr : public Expr {
-  std::shared_ptr<const Token> variable;
+  const Token *variable;
+  int depth, slot, upvalue;
 
-  VariableExpr(int line, int column, const char *file,
-               std::shared_ptr<const Token> &variable)
-      : variable(variable), Expr(line, column, file) {}
+  VariableExpr(const Token *location, const Token *variable)
+      : Expr(location), variable(variable), depth(-1), slot(-1), upvalue(-1) {}
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitVarExpr(this);
   }
 };
 
 struct AssignExpr : public Expr {
-  std::shared_ptr<const Token> variable;
-  std::unique_ptr<Expr> value;
+  const Token *variable;
+  Expr *value;
+  int depth, slot, upvalue;
 
-  AssignExpr(int line, int column, const char *file,
-             std::shared_ptr<const Token> &variable,
-             std::unique_ptr<Expr> &value)
-      : variable(variable), value(std::move(value)), Expr(line, column, file) {}
+  AssignExpr(const Token *location, const Token *variable, Expr *value)
+      : Expr(location), variable(variable), value(value), depth(-1), slot(-1),
+        upvalue(-1) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitAssignExpr(this);
@@ -144,14 +164,14 @@ struct AssignExpr : public Expr {
 };
 
 struct FnCallExpr : public Expr {
-  std::unique_ptr<Expr> callee;
-  std::vector<std::unique_ptr<Expr>> args;
+  Expr *callee;
+  std::span<Expr *> args;
+  // Set by the resolver when the value of the call is directly returned,
+  // the caller's frame can then be reused by the callee.
+  bool isTailCall;
 
-  FnCallExpr(int line, int column, const char *file,
-             std::unique_ptr<Expr> &callee,
-             std::vector<std::unique_ptr<Expr>> &args)
-      : callee(std::move(callee)), args(std::move(args)),
-        Expr(line, column, file) {}
+  FnCallExpr(const Token *location, Expr *callee, std::span<Expr *> args)
+      : Expr(location), callee(callee), args(args), isTailCall(false) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitCallExpr(this);
@@ -159,30 +179,29 @@ struct FnCallExpr : public Expr {
 };
 
 struct TernaryExpr : public Expr {
-  std::unique_ptr<Expr> condition;
-  std::unique_ptr<Expr> trueBranch;
-  std::unique_ptr<Expr> falseBranch;
+  Expr *condition;
+  Expr *trueBranch;
+  Expr *falseBranch;
 
-  TernaryExpr(int line, int column, const char *file,
-              std::unique_ptr<Expr> &condition,
-              std::unique_ptr<Expr> &trueBranch,
-              std::unique_ptr<Expr> &&falseBranch)
-      : condition(std::move(condition)), trueBranch(std::move(trueBranch)),
-        falseBranch(std::move(falseBranch)), Expr(line, column, file) {}
+  TernaryExpr(const Token *location, Expr *condition, Expr *trueBranch,
+              Expr *falseBranch)
+      : Expr(location), condition(condition), trueBranch(trueBranch),
+        falseBranch(falseBranch) {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitTernaryExpr(this);
   }
 };
 
+// Field accesses cache what they found on the instances the interpreter ran
+// them on.
 struct GetFieldExpr : public Expr {
-  std::shared_ptr<const Token> field;
-  std::unique_ptr<Expr> instance;
+  const Token *field;
+  Expr *instance;
+  InlineCache cache;
 
-  GetFieldExpr(int line, int column, const char *file,
-               std::unique_ptr<Expr> &instance,
-               std::shared_ptr<const Token> &field)
-      : instance(std::move(instance)), field(field), Expr(line, column, file) {}
+  GetFieldExpr(const Token *location, Expr *instance, const Token *field)
+      : Expr(location), field(field), instance(instance), cache() {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitGetFieldExpr(this);
@@ -190,16 +209,15 @@ struct GetFieldExpr : public Expr {
 };
 
 struct SetFieldExpr : public Expr {
-  std::shared_ptr<const Token> field;
-  std::unique_ptr<Expr> value;
-  std::unique_ptr<Expr> instance;
-
-  SetFieldExpr(int line, int column, const char *file,
-               std::unique_ptr<Expr> &instance,
-               std::shared_ptr<const Token> &field,
-               std::unique_ptr<Expr> &value)
-      : instance(std::move(instance)), field(field), value(std::move(value)),
-        Expr(line, column, file) {}
+  const Token *field;
+  Expr *value;
+  Expr *instance;
+  InlineCache cache;
+
+  SetFieldExpr(const Token *location, Expr *instance, const Token *field,
+               Expr *value)
+      : Expr(location), field(field), value(value), instance(instance),
+        cache() {}
 
   Value accept(Expression::Visitor *visitor) {
     return visitor->visitSetFieldExpr(this);
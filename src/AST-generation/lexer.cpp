@@ -1,23 +1,48 @@
 #include "lexer.hpp"
+#include "scan.hpp"
+#include "tokens/keywords.hpp"
 
-#include <cstdlib>
-#include <cstring>
-#include <fstream>
-#include <memory>
+#include <charconv>
 #include <string_view>
 
-#define MAKE_TOKEN(TYPE, LEXEME)                                               \
-  std::make_shared<const Token>(TYPE, LEXEME, file.line, file.column,          \
-                                file.filepath)
+#define MAKE_TOKEN(...) makeToken(file, __VA_ARGS__)
 
 namespace Lexer {
-std::shared_ptr<const Token> getNextToken(Source &file) {
-  if (file.stream.peek() == EOF) {
-    return MAKE_TOKEN(TokenType::Eof, 0);
-  }
+static const Token *makeToken(Source &file, TokenType type) {
+  return file.tokens.allocate(type, file.id, file.line, file.column);
+}
+
+static const Token *makeToken(Source &file, TokenType type,
+                              std::string_view lexeme) {
+  Token *token = file.tokens.allocate(type, file.id, file.line, file.column);
+  token->symbol = Symbol::intern(lexeme);
+  return token;
+}
+
+static const Token *makeToken(Source &file, TokenType type, float number) {
+  Token *token = file.tokens.allocate(type, file.id, file.line, file.column);
+  token->number = number;
+  return token;
+}
+
+static const Token *makeToken(Source &file, TokenType type, char character) {
+  Token *token = file.tokens.allocate(type, file.id, file.line, file.column);
+  token->character = character;
+  return token;
+}
 
+Source::Source(const char *filepath)
+    : content(filepath), current(content.begin()), end(content.end()),
+      line(1), column(0), id(SourceFiles::intern(filepath)),
+      loaded(content.loaded), tokens() {}
+
+const Token *getNextToken(Source &file) {
   skipWhitespace(file);
-  char ch = file.stream.peek();
+  if (file.isAtEnd()) {
+    return MAKE_TOKEN(TokenType::Eof);
+  }
+
+  char ch = file.peek();
 
   if (isDigit(ch)) {
     return makeNumberToken(file);
@@ -27,155 +52,159 @@ std::shared_ptr<const Token> getNextToken(Source &file) {
 
   switch ((ch = file.advance())) {
   case '(':
-    return MAKE_TOKEN(TokenType::LeftParen, 0);
+    return MAKE_TOKEN(TokenType::LeftParen);
   case ')':
-    return MAKE_TOKEN(TokenType::RightParen, 0);
+    return MAKE_TOKEN(TokenType::RightParen);
   case '{':
-    return MAKE_TOKEN(TokenType::LeftBrace, 0);
+    return MAKE_TOKEN(TokenType::LeftBrace);
   case '}':
-    return MAKE_TOKEN(TokenType::RightBrace, 0);
+    return MAKE_TOKEN(TokenType::RightBrace);
   case '?':
-    return MAKE_TOKEN(TokenType::Question, 0);
+    return MAKE_TOKEN(TokenType::Question);
   case ',':
-    return MAKE_TOKEN(TokenType::Comma, 0);
+    return MAKE_TOKEN(TokenType::Comma);
   case '.':
-    return MAKE_TOKEN(TokenType::Dot, 0);
+    return MAKE_TOKEN(TokenType::Dot);
   case ':':
-    return MAKE_TOKEN(TokenType::Colon, 0);
+    return MAKE_TOKEN(TokenType::Colon);
   case ';':
-    return MAKE_TOKEN(TokenType::Semicolon, 0);
+    return MAKE_TOKEN(TokenType::Semicolon);
   case '%':
-    return MAKE_TOKEN(TokenType::ModOp, 0);
+    return MAKE_TOKEN(TokenType::ModOp);
   case '&':
-    if (char _ch = file.stream.peek(); _ch == '&') {
+    if (char _ch = file.peek(); _ch == '&') {
       file.advance();
-      return MAKE_TOKEN(TokenType::And, 0);
+      return MAKE_TOKEN(TokenType::And);
     } else {
-      std::string str_msg = "invalid token '" + std::string(1, _ch) + "'";
-      char *msg = (char *)malloc(str_msg.size() + 1);
-      std::strncpy(msg, str_msg.c_str(), str_msg.size() + 1);
-      return MAKE_TOKEN(TokenType::Error, msg);
+      return MAKE_TOKEN(TokenType::Error,
+                        "invalid token '" + std::string(1, _ch) + "'");
     }
   case '|':
-    if (char _ch = file.stream.peek(); _ch == '|') {
+    if (char _ch = file.peek(); _ch == '|') {
       file.advance();
-      return MAKE_TOKEN(TokenType::Or, 0);
+      return MAKE_TOKEN(TokenType::Or);
     } else {
-      std::string str_msg = "invalid token '" + std::string(1, _ch) + "'";
-      char *msg = (char *)malloc(str_msg.size() + 1);
-      std::strncpy(msg, str_msg.c_str(), str_msg.size() + 1);
-      return MAKE_TOKEN(TokenType::Error, msg);
+      return MAKE_TOKEN(TokenType::Error,
+                        "invalid token '" + std::string(1, _ch) + "'");
     }
   case '-':
-    return MAKE_TOKEN(TokenType::Minus, 0);
+    return MAKE_TOKEN(TokenType::Minus);
   case '+':
-    return MAKE_TOKEN(TokenType::Plus, 0);
+    return MAKE_TOKEN(TokenType::Plus);
   case '/':
-    return MAKE_TOKEN(TokenType::Slash, 0);
+    return MAKE_TOKEN(TokenType::Slash);
   case '*':
-    return MAKE_TOKEN(TokenType::Star, 0);
+    return MAKE_TOKEN(TokenType::Star);
   case '!':
-    if (file.stream.peek() == '=') {
+    if (file.peek() == '=') {
       file.advance();
-      return MAKE_TOKEN(TokenType::BangEqual, 0);
+      return MAKE_TOKEN(TokenType::BangEqual);
     } else {
-      return MAKE_TOKEN(TokenType::Bang, 0);
+      return MAKE_TOKEN(TokenType::Bang);
     }
   case '=':
-    if (file.stream.peek() == '=') {
+    if (file.peek() == '=') {
       file.advance();
-      return MAKE_TOKEN(TokenType::EqualEqual, 0);
+      return MAKE_TOKEN(TokenType::EqualEqual);
     } else {
-      return MAKE_TOKEN(TokenType::Equal, 0);
+      return MAKE_TOKEN(TokenType::Equal);
     }
   case '>':
-    if (file.stream.peek() == '>') {
+    if (file.peek() == '>') {
       file.advance();
-      return MAKE_TOKEN(TokenType::ShiftRight, 0);
-    } else if (file.stream.peek() == '=') {
+      return MAKE_TOKEN(TokenType::ShiftRight);
+    } else if (file.peek() == '=') {
       file.advance();
-      return MAKE_TOKEN(TokenType::GreaterEqual, 0);
+      return MAKE_TOKEN(TokenType::GreaterEqual);
     } else {
-      return MAKE_TOKEN(TokenType::Greater, 0);
+      return MAKE_TOKEN(TokenType::Greater);
     }
   case '<':
-    if (file.stream.peek() == '<') {
+    if (file.peek() == '<') {
       file.advance();
-      return MAKE_TOKEN(TokenType::ShiftLeft, 0);
-    } else if (file.stream.peek() == '=') {
+      return MAKE_TOKEN(TokenType::ShiftLeft);
+    } else if (file.peek() == '=') {
       file.advance();
-      return MAKE_TOKEN(TokenType::LessEqual, 0);
+      return MAKE_TOKEN(TokenType::LessEqual);
     } else {
-      return MAKE_TOKEN(TokenType::Less, 0);
+      return MAKE_TOKEN(TokenType::Less);
     }
   case '\'': {
-    char lexeme = file.advance();
-    if (file.stream.peek() != '\'') {
+    char lexeme = file.isAtEnd() ? '\0' : file.advance();
+    if (file.peek() != '\'') {
       return MAKE_TOKEN(TokenType::Error, "A char must be one character long.");
     } else {
+      file.advance();
       return MAKE_TOKEN(TokenType::Char, lexeme);
     }
   }
   case '"': {
-    size_t len = 0;
-    char *lexeme = 0;
-    char new_ch = 0;
-
-    while (file.stream.peek() != EOF && file.stream.peek() != '"') {
-      if (file.stream.peek() == '\\') {
-        file.advance();
-
-        switch (file.stream.peek()) {
-        case 'n':
-          new_ch = '\n';
-          break;
-        case 't':
-          new_ch = '\t';
-          break;
-        case 'r':
-          new_ch = '\r';
-          break;
-        case '\'':
-          new_ch = '\'';
-          break;
-        case '\"':
-          new_ch = '"';
-          break;
-        case '\\':
-          new_ch = '\\';
-          break;
-        default:
-          return MAKE_TOKEN(TokenType::Error, "invalid escape sequence");
+    // Strings without escape sequences are interned straight from the file,
+    // the others are copied once the first escape is found.
+    const char *start = file.current;
+    std::string unescaped;
+    bool escaped = false;
+
+    while (!file.isAtEnd() && file.peek() != '"') {
+      if (file.peek() != '\\') {
+        const char *run = Scan::kernels->string(file.current, file.end);
+        if (escaped) {
+          unescaped.append(file.current, run);
         }
+        file.skipTo(run);
+        continue;
+      }
 
-        file.advance();
-      } else {
-        new_ch = file.advance();
+      if (!escaped) {
+        unescaped.assign(start, file.current);
+        escaped = true;
+      }
+      file.advance();
+
+      switch (file.peek()) {
+      case 'n':
+        unescaped.push_back('\n');
+        break;
+      case 't':
+        unescaped.push_back('\t');
+        break;
+      case 'r':
+        unescaped.push_back('\r');
+        break;
+      case '\'':
+        unescaped.push_back('\'');
+        break;
+      case '\"':
+        unescaped.push_back('"');
+        break;
+      case '\\':
+        unescaped.push_back('\\');
+        break;
+      default:
+        return MAKE_TOKEN(TokenType::Error, "invalid escape sequence");
       }
 
-      lexeme = (char *)realloc(lexeme, ++len);
-      lexeme[len - 1] = new_ch;
+      file.advance();
     }
 
-    if (file.stream.peek() == EOF) {
+    if (file.isAtEnd()) {
       return MAKE_TOKEN(TokenType::Error, "Unterminated string.");
-    } else {
-      file.advance();
-      return MAKE_TOKEN(TokenType::String, lexeme);
     }
-  }
-  }
 
-  if (file.stream.eof()) {
-    return MAKE_TOKEN(TokenType::Eof, 0);
+    std::string_view lexeme =
+        escaped ? std::string_view(unescaped)
+                : std::string_view(start, file.current - start);
+    file.advance();
+    return MAKE_TOKEN(TokenType::String, lexeme);
+  }
   }
 
   return MAKE_TOKEN(TokenType::Error, "\033[1;36mHow did you get here?\033[0m");
 }
 
 void skipWhitespace(Source &file) {
-  while (!file.stream.eof()) {
-    switch (file.stream.peek()) {
+  while (!file.isAtEnd()) {
+    switch (file.peek()) {
     case '\r':
     case '\n': {
       file.line++;
@@ -183,16 +212,14 @@ void skipWhitespace(Source &file) {
       file.column = 0;
     } break;
     case ' ': {
-      file.advance();
+      file.skipTo(Scan::kernels->spaces(file.current, file.end));
     } break;
     case '\t': {
       file.column += 3;
       file.advance();
     } break;
     case '#': {
-      while (file.stream.peek() != '\n' || file.stream.peek() != '\r') {
-        file.advance();
-      }
+      file.skipTo(Scan::kernels->line(file.current, file.end));
     } break;
     default:
       return;
@@ -200,139 +227,32 @@ void skipWhitespace(Source &file) {
   }
 }
 
-std::shared_ptr<const Token> makeNumberToken(Source &file) {
-  size_t size = 0;
-  char *strlexeme = 0;
-  bool is_float = false;
-
-  while (isDigit(file.stream.peek())) {
-    strlexeme = (char *)realloc(strlexeme, ++size);
-    strlexeme[size - 1] = file.advance();
-  }
+const Token *makeNumberToken(Source &file) {
+  const char *start = file.current;
 
-  if (file.stream.peek() == '.') {
-    is_float = true;
-    strlexeme = (char *)realloc(strlexeme, ++size);
-    strlexeme[size - 1] = file.advance();
+  file.skipTo(Scan::kernels->digits(file.current, file.end));
 
-    if (isDigit(file.stream.peek())) {
-      strlexeme = (char *)realloc(strlexeme, ++size);
-      strlexeme[size - 1] = file.advance();
-
-      while (isDigit(file.stream.peek())) {
-        strlexeme = (char *)realloc(strlexeme, ++size);
-        strlexeme[size - 1] = file.advance();
-      }
-    }
+  if (file.peek() == '.') {
+    file.advance();
+    file.skipTo(Scan::kernels->digits(file.current, file.end));
   }
 
-  strlexeme = (char *)realloc(strlexeme, ++size);
-  strlexeme[size - 1] = 0;
-
-  return MAKE_TOKEN(TokenType::Number,
-                    (is_float ? std::stof(strlexeme) : std::stoi(strlexeme)));
+  // Every number literal is a float, integers included.
+  float value = 0;
+  std::from_chars(start, file.current, value);
+  return MAKE_TOKEN(TokenType::Number, value);
 }
 
-std::shared_ptr<const Token> makeIdentifierToken(Source &file) {
-  size_t size = 0;
-  char *strlexeme = 0;
+const Token *makeIdentifierToken(Source &file) {
+  const char *start = file.current;
 
-  while (isAlpha(file.stream.peek()) || isDigit(file.stream.peek())) {
-    strlexeme = (char *)realloc(strlexeme, ++size);
-    strlexeme[size - 1] = file.advance();
-  }
-
-  strlexeme = (char *)realloc(strlexeme, ++size);
-  strlexeme[size - 1] = 0;
+  file.skipTo(Scan::kernels->identifier(file.current, file.end));
 
-  return MAKE_TOKEN(isIdentifierOrKeyword(strlexeme, size), strlexeme);
+  std::string_view lexeme(start, file.current - start);
+  return MAKE_TOKEN(isIdentifierOrKeyword(lexeme), lexeme);
 }
 
-TokenType isIdentifierOrKeyword(const char *lexeme, size_t len) {
-  switch (lexeme[0]) {
-  case 'b':
-    return checkKeyword(lexeme, len, 1, "reak", TokenType::Break);
-  case 'c':
-    if (len > 1) {
-      switch (lexeme[1]) {
-      case 'l':
-        return checkKeyword(lexeme, len, 2, "ass", TokenType::Class);
-      case 'o':
-        return checkKeyword(lexeme, len, 2, "ntinue", TokenType::Continue);
-      }
-    }
-
-    break;
-  case 'e':
-    return checkKeyword(lexeme, len, 1, "lse", TokenType::Else);
-  case 'f':
-    if (len > 1) {
-      switch (lexeme[1]) {
-      case 'a':
-        return checkKeyword(lexeme, len, 2, "lse", TokenType::False);
-      case 'o':
-        return checkKeyword(lexeme, len, 2, "r", TokenType::For);
-      case 'n':
-        return checkKeyword(lexeme, len, 2, "", TokenType::Fn);
-      }
-    }
-
-    break;
-  case 'i':
-    if (len > 1) {
-      switch (lexeme[1]) {
-      case 'f':
-        return checkKeyword(lexeme, len, 2, "", TokenType::If);
-      case 'm':
-        return checkKeyword(lexeme, len, 2, "port", TokenType::Import);
-      }
-    }
-
-    break;
-  case 'l':
-    if (len > 1) {
-      switch (lexeme[1]) {
-      case 'e':
-        return checkKeyword(lexeme, len, 2, "t", TokenType::Let);
-      case 'o':
-        return checkKeyword(lexeme, len, 2, "op", TokenType::Loop);
-      }
-    }
-    break;
-  case 'n':
-    return checkKeyword(lexeme, len, 1, "il", TokenType::Nil);
-  case 'r':
-    return checkKeyword(lexeme, len, 1, "eturn", TokenType::Return);
-  case 's':
-    return checkKeyword(lexeme, len, 1, "uper", TokenType::Super);
-  case 't':
-    if (len > 1) {
-      switch (lexeme[1]) {
-      case 'r':
-        return checkKeyword(lexeme, len, 2, "ue", TokenType::True);
-      case 'h':
-        return checkKeyword(lexeme, len, 2, "is", TokenType::This);
-      }
-    }
-    break;
-  case 'w':
-    return checkKeyword(lexeme, len, 1, "hile", TokenType::While);
-  }
-
-  return TokenType::Identifier;
-}
-
-TokenType checkKeyword(const char *token, size_t token_len, int startIndex,
-                       const std::string_view &restOfKeyword,
-                       TokenType typeIfMatch) {
-  if ((token_len - startIndex) != (restOfKeyword.length() + 1)) {
-    return TokenType::Identifier;
-  }
-
-  if (strcmp(token + startIndex, restOfKeyword.data())) {
-    return TokenType::Identifier;
-  }
-
-  return typeIfMatch;
+TokenType isIdentifierOrKeyword(std::string_view lexeme) {
+  return Keywords::find(lexeme);
 }
 } // namespace Lexer
@@ -1,45 +1,70 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "mapped_file.hpp"
 #include "tokens/token.hpp"
 #include "tokens/token_type.hpp"
 
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
 #include <memory>
+#include <string>
+#include <string_view>
 
 namespace Lexer {
+// The whole file, along with the tokens lexed from it. A `Source` has to
+// outlive the AST built from its tokens.
 struct Source {
-  Source(std::ifstream &file, const char *filepath)
-      : stream(std::move(file)), filepath(filepath), line(1), column(0) {}
+  Source(const char *filepath);
+  Source(const Source &) = delete;
 
+  inline bool isAtEnd() const { return current >= end; }
+  inline char peek() const { return isAtEnd() ? '\0' : *current; }
   inline char advance() {
-    char res = this->stream.get();
     ++column;
-    return res;
+    return *current++;
   }
+  // Advances up to `to`, which has to be on the same line.
+  inline void skipTo(const char *to) {
+    column += to - current;
+    current = to;
+  }
+
+  inline SourcePosition position() const {
+    return {id, static_cast<uint32_t>(current - content.begin()),
+            static_cast<int32_t>(line), static_cast<int32_t>(column)};
+  }
+  // Goes back, or forward, to a position taken from this file.
+  inline void seek(const SourcePosition &position) {
+    current = content.begin() + position.offset;
+    line = position.line;
+    column = position.column;
+  }
+
+private:
+  MappedFile content;
 
 public:
-  std::ifstream stream;
+  const char *current, *end;
   uint64_t line, column;
-  const char *filepath;
+  uint16_t id;
+  bool loaded;
+  // Every token made from this file.
+  TokenArena tokens;
 };
 
-std::shared_ptr<const Token> getNextToken(Source &file);
+const Token *getNextToken(Source &file);
 
-std::shared_ptr<const Token> makeIdentifierToken(Source &file);
-std::shared_ptr<const Token> makeNumberToken(Source &file);
+const Token *makeIdentifierToken(Source &file);
+const Token *makeNumberToken(Source &file);
 
 void skipWhitespace(Source &file);
 
-TokenType isIdentifierOrKeyword(const char *lexeme, size_t len);
-TokenType checkKeyword(const char *token, size_t token_len, int startIndex,
-                       const std::string_view &restOfKeyword,
-                       TokenType typeIfMatch);
+TokenType isIdentifierOrKeyword(std::string_view lexeme);
 
 inline constexpr bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
 inline constexpr bool isAlpha(char ch) {
-  return ch >= 'a' && ch <= 'z' || ch >= 'A' && ch <= 'Z' || ch == '_' ||
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' ||
          ch < -1;
 }
 } // namespace Lexer
@@ -58,10 +83,10 @@ inline constexpr bool isAlpha(char ch) {
 //   void skipWhitespace();
 //   void goToNextLine();
 
-//   std::shared_ptr<const Token> makeToken(TokenType, std::string = "");
-//   std::shared_ptr<const Token> makeNumberToken();
-//   std::shared_ptr<const Token> makeIdentifierToken();
-//   std::shared_ptr<const Token> makeErrorToken(std::string);
+//   const Token *makeToken(TokenType, std::string = "");
+//   const Token *makeNumberToken();
+//   const Token *makeIdentifierToken();
+//   const Token *makeErrorToken(std::string);
 
 //   TokenType isIdentifierOrKeywork();
 //   TokenType checkKeyword(int startIndex, const std::string &restOfKeyword,
@@ -83,7 +108,7 @@ inline constexpr bool isAlpha(char ch) {
 //   int getColumn();
 //   std::string getFilename();
 
-//   std::shared_ptr<const Token> getNextToken();
+//   const Token *getNextToken();
 // };
 
 #endif
@@ -0,0 +1,43 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *path)
+    : data(nullptr), length(0), mapped(false), buffer(), loaded(false) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory != MAP_FAILED) {
+      data = static_cast<const char *>(memory);
+      length = info.st_size;
+      mapped = true;
+    }
+  }
+
+  if (!mapped) {
+    char chunk[64 * 1024];
+
+    for (ssize_t n; (n = read(fd, chunk, sizeof(chunk))) > 0;) {
+      buffer.append(chunk, n);
+    }
+    data = buffer.data();
+    length = buffer.size();
+  }
+
+  close(fd);
+  loaded = true;
+}
+
+MappedFile::~MappedFile() {
+  if (mapped) {
+    munmap(const_cast<char *>(data), length);
+  }
+}
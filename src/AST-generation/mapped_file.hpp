@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// The whole content of a file, mapped in memory or read in one go when it
+// can't be mapped (pipes, empty files).
+class MappedFile {
+private:
+  const char *data;
+  size_t length;
+  bool mapped;
+  // Holds the file when it couldn't be mapped.
+  std::string buffer;
+
+public:
+  // False when the file couldn't be opened.
+  bool loaded;
+
+public:
+  MappedFile(const char *path);
+  MappedFile(const MappedFile &) = delete;
+  ~MappedFile();
+
+  inline const char *begin() const { return data; }
+  inline const char *end() const { return data + length; }
+  inline size_t size() const { return length; }
+};
+
+#endif
@@ -1,38 +1,84 @@
 #include "parser.hpp"
 #include "syntax_error.hpp"
+#include "thread_pool.hpp"
 
+#include <algorithm>
 #include <cstdint>
-#include <fcntl.h>
-#include <fstream>
 #include <iostream>
 #include <string>
-#include <sys/mman.h>
-#include <sys/stat.h>
+#include <thread>
 #include <variant>
 
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-  std::vector<std::unique_ptr<Stmt>> stmts;
+// Started the first time a file is imported.
+static ThreadPool &importPool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+std::vector<Stmt *> Parser::parse() {
+  parseFile();
+
+  std::vector<Stmt *> program;
+  std::string log;
+  stitch(program, log);
+
+  std::cout << log;
+  return program;
+}
 
+void Parser::parseFile() {
   while (!isAtEnd()) {
     try {
       if (match(TokenType::Import)) {
-        for (auto &&stmt : importStmt()) {
-          stmts.emplace_back(std::move(stmt));
-        }
+        importStmt();
+      } else if (skimFunctions && check(TokenType::Fn)) {
+        statements.push_back(skimFunction());
       } else {
-        stmts.emplace_back(declaration());
+        statements.push_back(declaration());
       }
     } catch (SyntaxError &e) {
-      hadError = true;
-      std::cout << e.what();
+      report(e);
       synchronize();
     }
   }
+}
+
+// Waits for the imported files in the order they were imported, so that the
+// program and the errors come out the same as if they were parsed one after
+// the other.
+void Parser::stitch(std::vector<Stmt *> &program, std::string &log) {
+  size_t position = 0, logPosition = 0;
+
+  for (Import &import : imports) {
+    program.insert(program.end(), statements.begin() + position,
+                   statements.begin() + import.position);
+    log.append(errors, logPosition, import.logPosition - logPosition);
+    position = import.position;
+    logPosition = import.logPosition;
+
+    import.parsed.get();
+    import.parser->stitch(program, log);
+    hadError |= import.parser->hadError;
+  }
 
-  return stmts;
+  program.insert(program.end(), statements.begin() + position,
+                 statements.end());
+  log.append(errors, logPosition);
 }
 
-std::unique_ptr<Stmt> Parser::declaration() {
+void Parser::files(std::vector<const char *> &paths) const {
+  paths.push_back(SourceFiles::name(source.id));
+  for (const Import &import : imports) {
+    import.parser->files(paths);
+  }
+}
+
+void Parser::report(SyntaxError &error) {
+  hadError = true;
+  errors += error.what();
+}
+
+Stmt *Parser::declaration() {
   if (match(TokenType::Let)) {
     return varDecl();
   } else if (match(TokenType::Fn)) {
@@ -44,37 +90,46 @@ std::unique_ptr<Stmt> Parser::declaration() {
   return statement();
 }
 
-std::vector<std::unique_ptr<Stmt>> Parser::importStmt() {
-  std::shared_ptr<const Token> path =
+void Parser::importStmt() {
+  const Token *path =
       consume("Expected path to file to import but instead got: '" +
                   type2str(current->type) + "'.",
               TokenType::String);
 
-  const char *filepath = std::get<const char *>(path->lexeme);
+  std::string filepath(path->lexeme());
   if (importedFiles.contains(filepath)) {
-    throw SyntaxError(previous.get(),
-                      "Recursive file import: '" + std::string(filepath) +
+    throw SyntaxError(previous,
+                      "Recursive file import: '" + filepath +
                           "' has already been imported or is the main file.");
   }
 
   importedFiles.insert(filepath);
-  std::ifstream sourceFile(filepath);
-
   CONSUME_SEMICOLON("import");
 
-  return (new Parser(sourceFile, filepath, importedFiles))->parse();
+  // Opened here so that a missing file is reported right away, it's lexed
+  // and parsed on the pool.
+  auto parser = std::make_unique<Parser>(filepath.c_str(), importedFiles,
+                                         skimFunctions);
+  if (!parser->loaded()) {
+    throw SyntaxError(path, "Couldn't load imported file '" + filepath + "'.");
+  }
+
+  Parser *imported = parser.get();
+  std::future<void> parsed =
+      importPool().submit([imported] { imported->parseFile(); });
+  imports.push_back(
+      {statements.size(), errors.size(), std::move(parser), std::move(parsed)});
 }
 
-std::unique_ptr<VarStmt> Parser::varDecl() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+VarStmt *Parser::varDecl() {
+  const Token *location = current;
 
-  std::shared_ptr<const Token> name =
+  const Token *name =
       consume("Expected variable name after 'let' keyword but instead got '" +
                   type2str(current->type) + "'.",
               TokenType::Identifier);
 
-  std::unique_ptr<Expr> value;
+  Expr *value = nullptr;
   if (match(TokenType::Equal)) {
     value = expression();
   }
@@ -82,15 +137,21 @@ std::unique_ptr<VarStmt> Parser::varDecl() {
   consume("Expected ';' at the end of a statement but instead got: '" +
               type2str(current->type) + "'.",
           TokenType::Semicolon);
-  return std::make_unique<VarStmt>(line, col, filename, name, value);
+  return nodes.make<VarStmt>(location, name, value);
 }
 
-std::unique_ptr<FnStmt> Parser::functionDecl(const std::string &kind) {
-  std::vector<std::shared_ptr<const Token>> args;
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+FnStmt *Parser::functionDecl(const std::string &kind) {
+  FnStmt *fn = functionSignature(kind);
+  fn->body = stmtSequence();
+  return fn;
+}
+
+// Parses a function up to the '{' its body starts with.
+FnStmt *Parser::functionSignature(const std::string &kind) {
+  std::vector<const Token *> args;
+  const Token *location = current;
 
-  std::shared_ptr<const Token> name =
+  const Token *name =
       consume("Expected " + kind + " name.", TokenType::Identifier);
 
   consume("Expected argument list after trait function name but instead got '" +
@@ -99,7 +160,7 @@ std::unique_ptr<FnStmt> Parser::functionDecl(const std::string &kind) {
 
   if (!check(TokenType::RightParen)) {
     do {
-      std::shared_ptr<const Token> arg = consume(
+      const Token *arg = consume(
           "Expected name of trait function parameter but instead got '" +
               type2str(current->type) + "'.",
           TokenType::Identifier);
@@ -113,45 +174,90 @@ std::unique_ptr<FnStmt> Parser::functionDecl(const std::string &kind) {
               type2str(current->type) + "'.",
           TokenType::LeftBrace);
 
-  return std::make_unique<FnStmt>(line, col, filename, name, args,
-                                  stmtSequence());
+  return nodes.make<FnStmt>(location, name, nodes.copy(args),
+                            std::span<Stmt *>());
+}
+
+// Top-level functions don't see any local, so their body can be resolved on
+// its own later. Only the identifiers in it are kept, the globals among them
+// count as used.
+FnStmt *Parser::skimFunction() {
+  SourcePosition position = source.position();
+  advance();
+  FnStmt *fn = functionSignature("function");
+
+  std::vector<Symbol> names;
+  for (int depth = 1; depth > 0; advance()) {
+    if (isAtEnd()) {
+      throw SyntaxError(current, "Expected '}' at the end of function '" +
+                                     std::string(fn->name->lexeme()) + "'.");
+    }
+
+    if (check(TokenType::LeftBrace)) {
+      depth++;
+    } else if (check(TokenType::RightBrace)) {
+      depth--;
+    } else if (check(TokenType::Identifier)) {
+      names.push_back(current->symbol);
+    }
+  }
+
+  fn->deferred = nodes.make<DeferredBody>(position, nodes.copy(names));
+  return fn;
+}
+
+FnStmt *Parser::deferredFunction(const SourcePosition &position) {
+  source.seek(position);
+  current = previous = Lexer::getNextToken(source);
+  errors.clear();
+  hadError = false;
+
+  FnStmt *fn = nullptr;
+  try {
+    fn = functionDecl("function");
+  } catch (SyntaxError &e) {
+    report(e);
+  }
+
+  std::cout << errors;
+  return hadError ? nullptr : fn;
 }
 
-std::unique_ptr<ClassStmt> Parser::classDecl() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+ClassStmt *Parser::classDecl() {
+  const Token *location = current;
 
-  std::shared_ptr<const Token> name = consume(
+  const Token *name = consume(
       "Expected class name but instead got '" + type2str(current->type) + "'.",
       TokenType::Identifier);
 
-  std::unique_ptr<VariableExpr> superclass;
+  VariableExpr *superclass = nullptr;
   if (match(TokenType::Colon)) {
-    std::shared_ptr<const Token> supername =
+    const Token *supername =
         consume("Expected superclass name.", TokenType::Identifier);
-    superclass = std::make_unique<VariableExpr>(line, col, filename, supername);
+    superclass = nodes.make<VariableExpr>(location, supername);
   }
 
-  auto clas = std::make_unique<ClassStmt>(line, col, filename, name, superclass,
-                                          std::vector<std::unique_ptr<Stmt>>());
   if (match(TokenType::Semicolon)) {
-    return clas;
+    return nodes.make<ClassStmt>(location, name, superclass,
+                                 std::span<Stmt *>());
   } else if (match(TokenType::LeftBrace)) {
+    std::vector<Stmt *> methods;
     while (!check(TokenType::RightBrace) && !isAtEnd()) {
-      clas->body.emplace_back(functionDecl("method"));
+      methods.push_back(functionDecl("method"));
     }
     consume("Expected closing '}'.", TokenType::RightBrace);
 
-    return clas;
+    return nodes.make<ClassStmt>(location, name, superclass,
+                                 nodes.copy(methods));
   } else {
-    throw SyntaxError(current.get(),
+    throw SyntaxError(current,
                       "Expected either a semicolon for an inline class "
                       "definition or a sequence of methods but instead got '" +
                           type2str(current->type) + "'.");
   }
 }
 
-std::unique_ptr<Stmt> Parser::statement() {
+Stmt *Parser::statement() {
   if (match(TokenType::LeftBrace)) {
     return scopedStmt();
   } else if (match(TokenType::If)) {
@@ -169,63 +275,58 @@ std::unique_ptr<Stmt> Parser::statement() {
   return expressionStmt();
 }
 
-std::unique_ptr<Stmt> Parser::scopedStmt() {
-  return std::make_unique<ScopedStmt>(current->line, current->column,
-                                      current->filename, stmtSequence());
+Stmt *Parser::scopedStmt() {
+  const Token *location = current;
+  return nodes.make<ScopedStmt>(location, stmtSequence());
 }
 
-std::unique_ptr<Stmt> Parser::ifStmt() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::ifStmt() {
+  const Token *location = current;
 
-  std::unique_ptr<Expr> cond = expression();
-  std::unique_ptr<Stmt> trueBranch = statement();
-  std::unique_ptr<Stmt> falseBranch;
+  Expr *cond = expression();
+  Stmt *trueBranch = statement();
+  Stmt *falseBranch = nullptr;
 
   if (match(TokenType::Else)) {
     falseBranch = statement();
   }
 
-  return std::make_unique<IfStmt>(line, col, filename, cond, trueBranch,
-                                  falseBranch);
+  return nodes.make<IfStmt>(location, cond, trueBranch, falseBranch);
 }
 
-std::unique_ptr<Stmt> Parser::whileStmt() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::whileStmt() {
+  const Token *location = current;
 
   auto condition = expression();
   auto body = statement();
-  return std::make_unique<WhileStmt>(line, col, filename, condition, body);
+  return nodes.make<WhileStmt>(location, condition, body);
 }
 
-std::unique_ptr<Stmt> Parser::loopStmt() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::loopStmt() {
+  const Token *location = current;
 
-  std::unique_ptr<Expr> cond = std::make_unique<LiteralExpr>(
-      line, col, filename,
-      std::make_shared<const Token>(TokenType::True, "true", previous->line,
-                                    previous->column, previous->filename));
-  return std::make_unique<WhileStmt>(line, col, filename, cond, statement());
+  Expr *cond = nodes.make<LiteralExpr>(
+      location,
+      source.tokens.allocate(TokenType::True, previous->file, previous->line,
+                             previous->column));
+  return nodes.make<WhileStmt>(location, cond, statement());
 }
 
-std::unique_ptr<Stmt> Parser::forStmt() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::forStmt() {
+  const Token *location = current;
 
   consume("Expected '(' at the beginning of for statement but instead got '" +
               type2str(current->type) + "'.",
           TokenType::LeftParen);
 
-  std::unique_ptr<Stmt> initializer;
+  Stmt *initializer = nullptr;
   if (match(TokenType::Let)) {
     initializer = varDecl();
   } else if (!match(TokenType::Semicolon)) {
     initializer = expressionStmt();
   }
 
-  std::unique_ptr<Expr> cond;
+  Expr *cond = nullptr;
   if (!check(TokenType::Semicolon)) {
     cond = expression();
   }
@@ -233,7 +334,7 @@ std::unique_ptr<Stmt> Parser::forStmt() {
               type2str(current->type) + "'.",
           TokenType::Semicolon);
 
-  std::unique_ptr<Expr> increment;
+  Expr *increment = nullptr;
   if (!check(TokenType::RightParen)) {
     increment = expression();
   }
@@ -241,190 +342,170 @@ std::unique_ptr<Stmt> Parser::forStmt() {
               type2str(current->type) + "'.",
           TokenType::RightParen);
 
-  std::unique_ptr<Stmt> body = statement();
+  Stmt *body = statement();
 
   if (!cond) {
-    cond = std::make_unique<LiteralExpr>(
-        line, col, filename,
-        std::make_shared<const Token>(TokenType::True, "true", previous->line,
-                                      previous->column, previous->filename));
+    cond = nodes.make<LiteralExpr>(
+        location,
+        source.tokens.allocate(TokenType::True, previous->file, previous->line,
+                               previous->column));
   }
 
-  return std::make_unique<ForStmt>(line, col, filename, initializer, cond,
-                                   increment, body);
+  return nodes.make<ForStmt>(location, initializer, cond, increment, body);
 }
 
-std::unique_ptr<Stmt> Parser::returnStmt() {
-  std::unique_ptr<Expr> value;
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::returnStmt() {
+  Expr *value = nullptr;
+  const Token *location = current;
 
   if (!check(TokenType::Semicolon)) {
     value = expression();
   }
   CONSUME_SEMICOLON("return");
 
-  return std::make_unique<ReturnStmt>(line, col, filename, value);
+  return nodes.make<ReturnStmt>(location, value);
 }
 
-std::unique_ptr<Stmt> Parser::expressionStmt() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Stmt *Parser::expressionStmt() {
+  const Token *location = current;
 
-  auto expr = std::make_unique<ExprStmt>(line, col, filename, expression());
+  ExprStmt *expr = nodes.make<ExprStmt>(location, expression());
   CONSUME_SEMICOLON("expression");
 
   return expr;
 }
 
-std::unique_ptr<Expr> Parser::expression() {
+Expr *Parser::expression() {
   if (match(TokenType::Break)) {
-    return std::make_unique<BreakExpr>(current->line, current->column,
-                                       current->filename);
+    return nodes.make<BreakExpr>(current);
   } else if (match(TokenType::Continue)) {
-    return std::make_unique<ContinueExpr>(current->line, current->column,
-                                          current->filename);
+    return nodes.make<ContinueExpr>(current);
   }
 
   return assignment();
 }
 
-std::unique_ptr<Expr> Parser::assignment() {
-  std::unique_ptr<Expr> left = orExpr();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::assignment() {
+  Expr *left = orExpr();
+  const Token *location = current;
 
   if (match(TokenType::Equal)) {
-    std::unique_ptr<Expr> value = assignment();
-    if (auto var = dynamic_cast<VariableExpr *>(left.get())) {
-      return std::make_unique<AssignExpr>(line, col, filename, var->variable,
-                                          value);
-    } else if (auto get = dynamic_cast<GetFieldExpr *>(left.get())) {
-      return std::make_unique<SetFieldExpr>(line, col, filename, get->instance,
-                                            get->field, value);
+    Expr *value = assignment();
+    if (auto var = dynamic_cast<VariableExpr *>(left)) {
+      return nodes.make<AssignExpr>(location, var->variable, value);
+    } else if (auto get = dynamic_cast<GetFieldExpr *>(left)) {
+      return nodes.make<SetFieldExpr>(location, get->instance, get->field,
+                                      value);
     }
 
-    throw SyntaxError(value.get(), "Invalid assignment value.");
+    throw SyntaxError(value, "Invalid assignment value.");
   } else if (match(TokenType::Question)) {
-    std::unique_ptr<Expr> trueExpr = assignment();
+    Expr *trueExpr = assignment();
     consume("Expected ':' between ternary expressions but instead got '" +
                 type2str(current->type) + "'.",
             TokenType::Colon);
 
-    return std::make_unique<TernaryExpr>(line, col, filename, left, trueExpr,
-                                         assignment());
+    return nodes.make<TernaryExpr>(location, left, trueExpr, assignment());
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::orExpr() {
-  std::unique_ptr<Expr> left = andExpr();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::orExpr() {
+  Expr *left = andExpr();
+  const Token *location = current;
 
   while (match(TokenType::Or)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left =
-        std::make_unique<BinaryExpr>(line, col, filename, left, andExpr(), op);
+    left = nodes.make<BinaryExpr>(location, left, andExpr(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::andExpr() {
-  std::unique_ptr<Expr> left = equality();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::andExpr() {
+  Expr *left = equality();
+  const Token *location = current;
 
   while (match(TokenType::And)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left =
-        std::make_unique<BinaryExpr>(line, col, filename, left, equality(), op);
+    left = nodes.make<BinaryExpr>(location, left, equality(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::equality() {
-  std::unique_ptr<Expr> left = comparison();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::equality() {
+  Expr *left = comparison();
+  const Token *location = current;
 
   while (match(TokenType::EqualEqual, TokenType::BangEqual)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left = std::make_unique<BinaryExpr>(line, col, filename, left, comparison(),
-                                        op);
+    left = nodes.make<BinaryExpr>(location, left, comparison(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::comparison() {
-  std::unique_ptr<Expr> left = term();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::comparison() {
+  Expr *left = term();
+  const Token *location = current;
 
   while (match(TokenType::Greater, TokenType::GreaterEqual, TokenType::Less,
                TokenType::LessEqual)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left = std::make_unique<BinaryExpr>(line, col, filename, left, term(), op);
+    left = nodes.make<BinaryExpr>(location, left, term(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::term() {
-  std::unique_ptr<Expr> left = factor();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::term() {
+  Expr *left = factor();
+  const Token *location = current;
 
   while (match(TokenType::Plus, TokenType::Minus, TokenType::ModOp)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left =
-        std::make_unique<BinaryExpr>(line, col, filename, left, factor(), op);
+    left = nodes.make<BinaryExpr>(location, left, factor(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::factor() {
-  std::unique_ptr<Expr> left = unary();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::factor() {
+  Expr *left = unary();
+  const Token *location = current;
 
   while (match(TokenType::Star, TokenType::Slash)) {
-    std::shared_ptr<const Token> op = previous;
+    const Token *op = previous;
 
-    left = std::make_unique<BinaryExpr>(line, col, filename, left, unary(), op);
+    left = nodes.make<BinaryExpr>(location, left, unary(), op);
   }
 
   return left;
 }
 
-std::unique_ptr<Expr> Parser::unary() {
+Expr *Parser::unary() {
   if (match(TokenType::Bang, TokenType::Minus)) {
-    std::shared_ptr<const Token> op = previous;
-    return std::make_unique<UnaryExpr>(current->line, current->column,
-                                       current->filename, unary(), op);
+    const Token *op = previous, *location = current;
+    return nodes.make<UnaryExpr>(location, unary(), op);
   } else {
     return call();
   }
 }
 
-std::unique_ptr<Expr> Parser::call() {
-  std::unique_ptr<Expr> expr = primary();
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::call() {
+  Expr *expr = primary();
+  const Token *location = current;
 
   while (1) {
     if (match(TokenType::LeftParen)) {
-      std::vector<std::unique_ptr<Expr>> args;
+      std::vector<Expr *> args;
       if (!check(TokenType::RightParen)) {
         do {
           args.emplace_back(expression());
@@ -434,13 +515,13 @@ std::unique_ptr<Expr> Parser::call() {
       consume("Expected ')' after function call but instead got '" +
                   type2str(current->type) + "'.",
               TokenType::RightParen);
-      expr = std::make_unique<FnCallExpr>(line, col, filename, expr, args);
+      expr = nodes.make<FnCallExpr>(location, expr, nodes.copy(args));
     } else if (match(TokenType::Dot)) {
-      std::shared_ptr<const Token> prop =
+      const Token *prop =
           consume("Expected class property or method but instead got '" +
                       type2str(current->type) + "'.",
                   TokenType::Identifier);
-      expr = std::make_unique<GetFieldExpr>(line, col, filename, expr, prop);
+      expr = nodes.make<GetFieldExpr>(location, expr, prop);
     } else {
       break;
     }
@@ -449,31 +530,30 @@ std::unique_ptr<Expr> Parser::call() {
   return expr;
 }
 
-std::unique_ptr<Expr> Parser::primary() {
-  int line = current->line, col = current->column;
-  const char *filename = current->filename;
+Expr *Parser::primary() {
+  const Token *location = current;
 
   if (match(TokenType::Super)) {
     consume("Expected '.' after super keyword.", TokenType::Dot);
-    std::shared_ptr<const Token> field =
+    const Token *field =
         consume("Expected superclass field.", TokenType::Identifier);
 
-    return std::make_unique<SuperExpr>(line, col, filename, field);
+    return nodes.make<SuperExpr>(location, field);
   } else if (match(TokenType::This)) {
-    return std::make_unique<ThisExpr>(line, col, filename, previous);
+    return nodes.make<ThisExpr>(location, previous);
   } else if (match(TokenType::Identifier)) {
-    return std::make_unique<VariableExpr>(line, col, filename, previous);
+    return nodes.make<VariableExpr>(location, previous);
   } else if (match(TokenType::Number, TokenType::Char, TokenType::String,
                    TokenType::True, TokenType::False, TokenType::Nil)) {
-    return std::make_unique<LiteralExpr>(line, col, filename, previous);
+    return nodes.make<LiteralExpr>(location, previous);
   } else if (match(TokenType::LeftParen)) {
-    std::unique_ptr<Expr> expr = expression();
+    Expr *expr = expression();
     consume("Missing closing parenthesis ')' after expression.",
             TokenType::RightParen);
-    return std::make_unique<GroupingExpr>(line, col, filename, expr);
+    return nodes.make<GroupingExpr>(location, expr);
   }
 
-  throw SyntaxError(current.get(), "'" + type2str(current->type) +
+  throw SyntaxError(current, "'" + type2str(current->type) +
                                        "' not a valid expression statement.");
 }
 
@@ -503,7 +583,7 @@ void Parser::synchronize() {
   }
 }
 
-std::shared_ptr<const Token> Parser::advance() {
+const Token *Parser::advance() {
   previous = current;
 
   if (isAtEnd()) {
@@ -512,21 +592,20 @@ std::shared_ptr<const Token> Parser::advance() {
 
   current = Lexer::getNextToken(this->source);
   if (current->type == TokenType::Error) {
-    throw SyntaxError(current.get(), std::get<const char *>(current->lexeme));
+    throw SyntaxError(current, std::string(current->lexeme()));
   } else {
     return previous;
   }
 }
 
-std::vector<std::unique_ptr<Stmt>> Parser::stmtSequence() {
-  std::vector<std::unique_ptr<Stmt>> stmts;
+std::span<Stmt *> Parser::stmtSequence() {
+  std::vector<Stmt *> stmts;
 
   while (!check(TokenType::RightBrace) && !isAtEnd()) {
     try {
       stmts.push_back(declaration());
     } catch (SyntaxError &e) {
-      hadError = true;
-      std::cout << e.what();
+      report(e);
       synchronize();
     }
   }
@@ -534,7 +613,7 @@ std::vector<std::unique_ptr<Stmt>> Parser::stmtSequence() {
   consume("Expected '}' at scope block end but instead got '" +
               type2str(current->type) + "'.",
           TokenType::RightBrace);
-  return stmts;
+  return nodes.copy(stmts);
 }
 
 template <typename... TokenTypes>
@@ -547,13 +626,13 @@ bool Parser::match(const TokenTypes &...types) {
   return true;
 }
 
-std::shared_ptr<const Token> Parser::consume(const std::string &msg,
-                                             const TokenType &expected) {
+const Token *Parser::consume(const std::string &msg,
+                             const TokenType &expected) {
   if (!check(expected)) {
-    throw SyntaxError(current.get(), msg);
+    throw SyntaxError(current, msg);
   }
 
-  std::shared_ptr<const Token> res = current;
+  const Token *res = current;
   advance();
   return res;
 }
@@ -1,13 +1,17 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "ast_arena.hpp"
 #include "expressions.hpp"
 #include "lexer.hpp"
 #include "statements.hpp"
+#include "syntax_error.hpp"
 #include "tokens/token_type.hpp"
 
-#include <fstream>
+#include <future>
 #include <memory>
+#include <span>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -17,24 +21,51 @@
 
 class Parser {
 public:
-  Parser(std::ifstream &file, const char *filename)
-      : source(Lexer::Source(file, filename)),
-        current(Lexer::getNextToken(this->source)), previous(current),
-        hadError(false) {
+  // With `skimFunctions`, the bodies of top-level functions are only
+  // brace-matched, see `deferredFunction`. Imported files are parsed the same
+  // way.
+  Parser(const char *filename, bool skimFunctions = false)
+      : source(filename), current(Lexer::getNextToken(this->source)),
+        previous(current), skimFunctions(skimFunctions), hadError(false) {
     importedFiles.insert(filename);
   }
 
-  Parser(std::ifstream &file, const char *filename,
-         std::unordered_set<std::string> &importedFiles)
-      : importedFiles(importedFiles), source(Lexer::Source(file, filename)),
-        current(Lexer::getNextToken(this->source)), previous(current),
-        hadError(false) {}
+  Parser(const char *filename, std::unordered_set<std::string> &importedFiles,
+         bool skimFunctions)
+      : source(filename), current(Lexer::getNextToken(this->source)),
+        previous(current), importedFiles(importedFiles),
+        skimFunctions(skimFunctions), hadError(false) {}
 
-  std::vector<std::unique_ptr<Stmt>> parse();
+  // False when the file couldn't be read.
+  inline bool loaded() const { return source.loaded; }
+
+  // Parses the file and everything it imports. Imported files are parsed in
+  // parallel, their statements end up where they were imported.
+  std::vector<Stmt *> parse();
+
+  // Appends the path of this file and of every file it imported.
+  void files(std::vector<const char *> &paths) const;
+
+  // Parses the whole function that was skimmed at `position` of this file.
+  // Null, after printing them, if its body has syntax errors.
+  FnStmt *deferredFunction(const SourcePosition &position);
 
 private:
+  // A file imported by this one, parsed on the thread pool.
+  struct Import {
+    // How many statements and how much of the error log of this file come
+    // before the import.
+    size_t position, logPosition;
+    std::unique_ptr<Parser> parser;
+    std::future<void> parsed;
+  };
+
+  void parseFile();
+  void stitch(std::vector<Stmt *> &program, std::string &log);
+  void report(SyntaxError &);
+
   void synchronize();
-  std::shared_ptr<const Token> advance();
+  const Token *advance();
 
   inline bool isAtEnd() { return current->type == TokenType::Eof; }
 
@@ -44,43 +75,51 @@ private:
   }
 
   template <typename... TokenTypes> bool match(const TokenTypes &...types);
-  std::shared_ptr<const Token> consume(const std::string &msg,
-                                       const TokenType &expected);
-
-  std::vector<std::unique_ptr<Stmt>> importStmt();
-  std::unique_ptr<FnStmt> functionDecl(const std::string &);
-  std::unique_ptr<VarStmt> varDecl();
-  std::unique_ptr<ClassStmt> classDecl();
-
-  std::vector<std::unique_ptr<Stmt>> stmtSequence();
-
-  std::unique_ptr<Stmt> declaration();
-  std::unique_ptr<Stmt> statement();
-  std::unique_ptr<Stmt> ifStmt();
-  std::unique_ptr<Stmt> whileStmt();
-  std::unique_ptr<Stmt> loopStmt();
-  std::unique_ptr<Stmt> forStmt();
-  std::unique_ptr<Stmt> returnStmt();
-  std::unique_ptr<Stmt> scopedStmt();
-  std::unique_ptr<Stmt> expressionStmt();
-
-  std::unique_ptr<Expr> expression();
-  std::unique_ptr<Expr> assignment();
-  std::unique_ptr<Expr> orExpr();
-  std::unique_ptr<Expr> andExpr();
-  std::unique_ptr<Expr> equality();
-  std::unique_ptr<Expr> comparison();
-  std::unique_ptr<Expr> term();
-  std::unique_ptr<Expr> factor();
-  std::unique_ptr<Expr> unary();
-  std::unique_ptr<Expr> call();
-  std::unique_ptr<Expr> primary();
+  const Token *consume(const std::string &msg, const TokenType &expected);
+
+  void importStmt();
+  FnStmt *functionDecl(const std::string &);
+  FnStmt *functionSignature(const std::string &);
+  FnStmt *skimFunction();
+  VarStmt *varDecl();
+  ClassStmt *classDecl();
+
+  std::span<Stmt *> stmtSequence();
+
+  Stmt *declaration();
+  Stmt *statement();
+  Stmt *ifStmt();
+  Stmt *whileStmt();
+  Stmt *loopStmt();
+  Stmt *forStmt();
+  Stmt *returnStmt();
+  Stmt *scopedStmt();
+  Stmt *expressionStmt();
+
+  Expr *expression();
+  Expr *assignment();
+  Expr *orExpr();
+  Expr *andExpr();
+  Expr *equality();
+  Expr *comparison();
+  Expr *term();
+  Expr *factor();
+  Expr *unary();
+  Expr *call();
+  Expr *primary();
 
 private:
   Lexer::Source source;
-  std::shared_ptr<const Token> current;
-  std::shared_ptr<const Token> previous;
+  // Every node parsed from this file, the AST lives as long as the parser.
+  AstArena nodes;
+  const Token *current;
+  const Token *previous;
   std::unordered_set<std::string> importedFiles;
+  // Statements and syntax errors of this file only.
+  std::vector<Stmt *> statements;
+  std::string errors;
+  std::vector<Import> imports;
+  bool skimFunctions;
 
 public:
   bool hadError;
@@ -0,0 +1,134 @@
+#include "scan.hpp"
+#include "lexer.hpp"
+
+#include <cstdint>
+
+#if defined(__x86_64__)
+#define SCAN_X86
+#include <emmintrin.h>
+#endif
+
+namespace Scan {
+static const char *identifierScalar(const char *p, const char *end) {
+  while (p < end && (Lexer::isAlpha(*p) || Lexer::isDigit(*p))) {
+    p++;
+  }
+  return p;
+}
+
+static const char *digitsScalar(const char *p, const char *end) {
+  while (p < end && Lexer::isDigit(*p)) {
+    p++;
+  }
+  return p;
+}
+
+static const char *spacesScalar(const char *p, const char *end) {
+  while (p < end && *p == ' ') {
+    p++;
+  }
+  return p;
+}
+
+static const char *lineScalar(const char *p, const char *end) {
+  while (p < end && *p != '\n' && *p != '\r') {
+    p++;
+  }
+  return p;
+}
+
+static const char *stringScalar(const char *p, const char *end) {
+  while (p < end && *p != '"' && *p != '\\') {
+    p++;
+  }
+  return p;
+}
+
+static const Kernels scalar = {"scalar",     identifierScalar, digitsScalar,
+                               spacesScalar, lineScalar,       stringScalar};
+
+#ifdef SCAN_X86
+// The kernels below look at a whole block at once and build a mask with a
+// bit set for every byte that stops the run, the first set bit is the answer.
+// What's left once there are no more full blocks goes through the scalar
+// kernel.
+
+// Sets the bytes of `x` that are in ['lo', 'hi']. There are only signed byte
+// comparisons, so the range is moved down to start at -128.
+static inline __m128i inRange(__m128i x, char lo, char hi) {
+  __m128i shifted =
+      _mm_add_epi8(x, _mm_set1_epi8(static_cast<char>(128 - lo)));
+  return _mm_cmplt_epi8(shifted,
+                        _mm_set1_epi8(static_cast<char>(hi - lo + 1 - 128)));
+}
+
+static inline uint32_t identifierStops(__m128i x) {
+  __m128i letters = inRange(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+  __m128i digits = inRange(x, '0', '9');
+  __m128i underscores = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+  // Same as `isAlpha`: bytes of multi-byte UTF-8 sequences, but not 0xff.
+  __m128i nonAscii = _mm_cmplt_epi8(x, _mm_set1_epi8(-1));
+
+  __m128i run = _mm_or_si128(_mm_or_si128(letters, digits),
+                             _mm_or_si128(underscores, nonAscii));
+  return _mm_movemask_epi8(run) ^ 0xffff;
+}
+
+static inline uint32_t digitStops(__m128i x) {
+  return _mm_movemask_epi8(inRange(x, '0', '9')) ^ 0xffff;
+}
+
+static inline uint32_t spaceStops(__m128i x) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(' '))) ^ 0xffff;
+}
+
+static inline uint32_t lineStops(__m128i x) {
+  return _mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+                   _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+}
+
+static inline uint32_t stringStops(__m128i x) {
+  return _mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+                   _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))));
+}
+
+template <uint32_t (*stops)(__m128i),
+          const char *(*tail)(const char *, const char *)>
+static const char *scanSSE2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    uint32_t mask =
+        stops(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return tail(p, end);
+}
+
+static const Kernels sse2 = {
+    "sse2",
+    scanSSE2<identifierStops, identifierScalar>,
+    scanSSE2<digitStops, digitsScalar>,
+    scanSSE2<spaceStops, spacesScalar>,
+    scanSSE2<lineStops, lineScalar>,
+    scanSSE2<stringStops, stringScalar>,
+};
+#endif
+
+std::vector<const Kernels *> available() {
+  std::vector<const Kernels *> sets = {&scalar};
+
+#ifdef SCAN_X86
+  // SSE2 is part of x86-64. AVX2 kernels measured no faster, even on long
+  // comments and strings.
+  sets.push_back(&sse2);
+#endif
+
+  return sets;
+}
+
+const Kernels *kernels = available().back();
+} // namespace Scan
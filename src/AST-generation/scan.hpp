@@ -0,0 +1,28 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <vector>
+
+// Kernels the lexer uses to skip over runs of bytes. Each one returns the
+// first byte of `[begin, end)` where the run stops, or `end`.
+namespace Scan {
+struct Kernels {
+  const char *name;
+  // Letters, digits, underscores and non-ASCII bytes.
+  const char *(*identifier)(const char *begin, const char *end);
+  const char *(*digits)(const char *begin, const char *end);
+  const char *(*spaces)(const char *begin, const char *end);
+  // Up to the next '\n' or '\r'.
+  const char *(*line)(const char *begin, const char *end);
+  // Up to the next '"' or '\\'.
+  const char *(*string)(const char *begin, const char *end);
+};
+
+// Every set of kernels this CPU can run, the best one last.
+std::vector<const Kernels *> available();
+
+// The kernels the lexer calls, the best available ones unless changed.
+extern const Kernels *kernels;
+} // namespace Scan
+
+#endif
@@ -2,129 +2,145 @@
 #define STATEMENTS_H
 
 #include "expressions.hpp"
-#include <memory>
+
+#include <span>
+#include <vector>
 
 struct Stmt {
-  const char *filename;
-  int line, column;
+  const Token *location;
 
-  Stmt(int line, int column, const char *filename)
-      : line(line), column(column), filename(filename) {}
+  Stmt(const Token *location) : location(location) {}
 
-  virtual ~Stmt() {}
   virtual void accept(Statement::Visitor *) = 0;
 };
 
-struct FnStmt : public Stmt {
-  std::shared_ptr<const Token> name;
-  std::vector<std::shared_ptr<const Token>> args;
-  std::vector<std::unique_ptr<Stmt>> body;
+// A variable of an enclosing function that a closure uses. Either the slot
+// `index` of the scope `depth` levels above the one the closure is created
+// in, or the upvalue `index` of the function that creates it.
+struct UpvalueRef {
+  bool isLocal;
+  int depth, index;
+
+  inline bool operator==(const UpvalueRef &) const = default;
+};
 
-  FnStmt(int line, int column, const char *file,
-         std::shared_ptr<const Token> &name,
-         std::vector<std::shared_ptr<const Token>> &args,
-         std::vector<std::unique_ptr<Stmt>> &&body)
-      : name(name), args(args), body(std::move(body)),
-        Stmt(line, column, file) {}
+// The body of a function the parser only skimmed: where to parse it from, and
+// the identifiers in it.
+struct DeferredBody {
+  SourcePosition position;
+  std::span<Symbol> names;
+};
+
+// Declarations get the `slot` of the name they define from the resolver, -1
+// for globals, and local ones whether that name is ever `used`. Statements
+// that open a scope record how many slots it needs in `scopeSize` and whether
+// a closure captures one of them in `captured`. Functions also get the list
+// of variables they capture. A top-level function can be `deferred`, its body
+// is parsed and resolved the first time it's called.
+struct FnStmt : public Stmt {
+  const Token *name;
+  std::span<const Token *> args;
+  std::span<Stmt *> body;
+  std::vector<UpvalueRef> upvalues;
+  DeferredBody *deferred;
+  int slot, scopeSize;
+  bool captured, used;
+
+  FnStmt(const Token *location, const Token *name,
+         std::span<const Token *> args, std::span<Stmt *> body)
+      : Stmt(location), name(name), args(args), body(body), upvalues(),
+        deferred(nullptr), slot(-1), scopeSize(0), captured(false),
+        used(false) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitFnStmt(this); }
 };
 
 struct VarStmt : public Stmt {
-  std::shared_ptr<const Token> name;
-  std::unique_ptr<Expr> value;
+  const Token *name;
+  Expr *value;
+  int slot;
+  bool used;
 
-  VarStmt(int line, int column, const char *file,
-          std::shared_ptr<const Token> &name, std::unique_ptr<Expr> &value)
-      : name(name), value(std::move(value)), Stmt(line, column, file) {}
+  VarStmt(const Token *location, const Token *name, Expr *value)
+      : Stmt(location), name(name), value(value), slot(-1), used(false) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitVarStmt(this); }
 };
 
 struct ClassStmt : public Stmt {
-  std::shared_ptr<const Token> name;
-  std::unique_ptr<VariableExpr> superclass;
-  std::vector<std::unique_ptr<Stmt>> body;
+  const Token *name;
+  VariableExpr *superclass;
+  std::span<Stmt *> body;
+  int slot;
 
-  ClassStmt(int line, int column, const char *file,
-            std::shared_ptr<const Token> &name,
-            std::unique_ptr<VariableExpr> &superclass,
-            std::vector<std::unique_ptr<Stmt>> &&body)
-      : name(name), superclass(std::move(superclass)), body(std::move(body)),
-        Stmt(line, column, file) {}
+  ClassStmt(const Token *location, const Token *name,
+            VariableExpr *superclass, std::span<Stmt *> body)
+      : Stmt(location), name(name), superclass(superclass), body(body),
+        slot(-1) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitClassStmt(this); }
 };
 
 struct IfStmt : public Stmt {
-  std::unique_ptr<Expr> condition;
-  std::unique_ptr<Stmt> trueBranch;
-  std::unique_ptr<Stmt> falseBranch;
+  Expr *condition;
+  Stmt *trueBranch;
+  Stmt *falseBranch;
 
-  IfStmt(int line, int column, const char *file,
-         std::unique_ptr<Expr> &condition, std::unique_ptr<Stmt> &trueBranch,
-         std::unique_ptr<Stmt> &falseBranch)
-      : condition(std::move(condition)), trueBranch(std::move(trueBranch)),
-        falseBranch(std::move(falseBranch)), Stmt(line, column, file) {}
+  IfStmt(const Token *location, Expr *condition, Stmt *trueBranch,
+         Stmt *falseBranch)
+      : Stmt(location), condition(condition), trueBranch(trueBranch),
+        falseBranch(falseBranch) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitIfStmt(this); }
 };
 
 struct WhileStmt : public Stmt {
-  std::unique_ptr<Expr> condition;
-  std::unique_ptr<Stmt> body;
-
-  WhileStmt(int line, int column, const char *file, std::unique_ptr<Expr> &cond,
-            std::unique_ptr<Stmt> &body)
-      : condition(std::move(cond)), body(std::move(body)),
-        Stmt(line, column, file) {}
+  Expr *condition;
+  Stmt *body;
 
-  WhileStmt(int line, int column, const char *file, std::unique_ptr<Expr> &cond,
-            std::unique_ptr<Stmt> &&body)
-      : condition(std::move(cond)), body(std::move(body)),
-        Stmt(line, column, file) {}
+  WhileStmt(const Token *location, Expr *cond, Stmt *body)
+      : Stmt(location), condition(cond), body(body) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitWhileStmt(this); }
 };
 
 struct ForStmt : public Stmt {
-  std::unique_ptr<Expr> increment, condition;
-  std::unique_ptr<Stmt> initializer, body;
+  Expr *increment, *condition;
+  Stmt *initializer, *body;
+  int scopeSize;
+  bool captured;
 
-  ForStmt(int line, int column, const char *file,
-          std::unique_ptr<Stmt> &initializer, std::unique_ptr<Expr> &cond,
-          std::unique_ptr<Expr> &increment, std::unique_ptr<Stmt> &body)
-      : initializer(std::move(initializer)), condition(std::move(cond)),
-        increment(std::move(increment)), body(std::move(body)),
-        Stmt(line, column, file) {}
+  ForStmt(const Token *location, Stmt *initializer, Expr *cond,
+          Expr *increment, Stmt *body)
+      : Stmt(location), increment(increment), condition(cond),
+        initializer(initializer), body(body), scopeSize(0), captured(false) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitForStmt(this); }
 };
 
 struct ScopedStmt : public Stmt {
-  std::vector<std::unique_ptr<Stmt>> body;
+  std::span<Stmt *> body;
+  int scopeSize;
+  bool captured;
 
-  ScopedStmt(int line, int column, const char *file,
-             std::vector<std::unique_ptr<Stmt>> &&body)
-      : body(std::move(body)), Stmt(line, column, file) {}
+  ScopedStmt(const Token *location, std::span<Stmt *> body)
+      : Stmt(location), body(body), scopeSize(0), captured(false) {}
   void accept(Statement::Visitor *visitor) { visitor->visitScopedStmt(this); }
 };
 
 struct ExprStmt : public Stmt {
-  std::unique_ptr<Expr> expr;
+  Expr *expr;
 
-  ExprStmt(int line, int column, const char *file, std::unique_ptr<Expr> &&expr)
-      : expr(std::move(expr)), Stmt(line, column, file) {}
+  ExprStmt(const Token *location, Expr *expr) : Stmt(location), expr(expr) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitExprStmt(this); }
 };
 
 struct ReturnStmt : public Stmt {
-  std::unique_ptr<Expr> value;
+  Expr *value;
 
-  ReturnStmt(int line, int column, const char *file,
-             std::unique_ptr<Expr> &value)
-      : value(std::move(value)), Stmt(line, column, file) {}
+  ReturnStmt(const Token *location, Expr *value)
+      : Stmt(location), value(value) {}
 
   void accept(Statement::Visitor *visitor) { visitor->visitReturnStmt(this); }
 };
@@ -17,15 +17,17 @@ public:
 public:
   SyntaxError(const Token *errToken, const std::string &msg)
       : line(errToken->line), column(errToken->column),
-        filename(errToken->filename), msg(msg) {}
+        filename(errToken->filename()), msg(msg) {}
 
   SyntaxError(Expr *errExpr, const std::string &msg)
-      : line(errExpr->line), column(errExpr->column), filename(errExpr->file),
-        msg(msg) {}
+      : SyntaxError(errExpr->location, msg) {}
 
   SyntaxError(Stmt *errStmt, const std::string &msg)
-      : line(errStmt->line), column(errStmt->column),
-        filename(errStmt->filename), msg(msg) {}
+      : SyntaxError(errStmt->location, msg) {}
+
+  SyntaxError(const SourceLocation &location, const std::string &msg)
+      : line(location.line), column(location.column),
+        filename(location.filename), msg(msg) {}
 
   std::string what();
 };
@@ -0,0 +1,52 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned threads)
+    : workers(), tasks(), mutex(), available(), stopping(false) {
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  available.notify_all();
+
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  std::future<void> done = packaged.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push(std::move(packaged));
+  }
+  available.notify_one();
+
+  return done;
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::packaged_task<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      available.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+
+    task();
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run the tasks submitted to it in the
+// order they were submitted. Tasks may submit more tasks but must not wait
+// for them, only threads outside of the pool can.
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::packaged_task<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable available;
+  bool stopping;
+
+  void work();
+
+public:
+  ThreadPool(unsigned threads);
+  ThreadPool(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  std::future<void> submit(std::function<void()> task);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include "token_type.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reserved words, looked up through a perfect hash built at compile time.
+// Adding a keyword only means adding it to `list`.
+namespace Keywords {
+struct Keyword {
+  std::string_view spelling;
+  TokenType type;
+};
+
+// `and` and `or` are spelled `&&` and `||`, `main` isn't reserved.
+inline constexpr std::array<Keyword, 17> list = {{
+    {"break", TokenType::Break},
+    {"class", TokenType::Class},
+    {"continue", TokenType::Continue},
+    {"else", TokenType::Else},
+    {"false", TokenType::False},
+    {"fn", TokenType::Fn},
+    {"for", TokenType::For},
+    {"if", TokenType::If},
+    {"import", TokenType::Import},
+    {"let", TokenType::Let},
+    {"loop", TokenType::Loop},
+    {"nil", TokenType::Nil},
+    {"return", TokenType::Return},
+    {"super", TokenType::Super},
+    {"this", TokenType::This},
+    {"true", TokenType::True},
+    {"while", TokenType::While},
+}};
+
+inline constexpr size_t TABLE_SIZE = 64;
+
+inline constexpr size_t MIN_LENGTH = [] {
+  size_t min = list[0].spelling.size();
+  for (const Keyword &keyword : list) {
+    min = std::min(min, keyword.spelling.size());
+  }
+  return min;
+}();
+
+inline constexpr size_t MAX_LENGTH = [] {
+  size_t max = 0;
+  for (const Keyword &keyword : list) {
+    max = std::max(max, keyword.spelling.size());
+  }
+  return max;
+}();
+
+// Only looks at the length and the first two and last characters, `word` has
+// to be at least `MIN_LENGTH` long.
+inline constexpr size_t hash(std::string_view word, uint32_t seed) {
+  uint32_t h = word.size();
+  h = h * seed + static_cast<uint8_t>(word[0]);
+  h = h * seed + static_cast<uint8_t>(word[1]);
+  h = h * seed + static_cast<uint8_t>(word[word.size() - 1]);
+  return (h ^ (h >> 11)) % TABLE_SIZE;
+}
+
+// The first seed that gives every keyword its own slot.
+inline constexpr uint32_t seed = [] {
+  for (uint32_t seed = 1;; seed++) {
+    std::array<bool, TABLE_SIZE> used{};
+    bool collides = false;
+
+    for (const Keyword &keyword : list) {
+      size_t slot = hash(keyword.spelling, seed);
+      collides |= used[slot];
+      used[slot] = true;
+    }
+
+    if (!collides) {
+      return seed;
+    }
+  }
+}();
+
+// Slots no keyword hashed to are left empty and never match.
+inline constexpr std::array<Keyword, TABLE_SIZE> table = [] {
+  std::array<Keyword, TABLE_SIZE> table{};
+  for (Keyword &slot : table) {
+    slot.type = TokenType::Identifier;
+  }
+
+  for (const Keyword &keyword : list) {
+    table[hash(keyword.spelling, seed)] = keyword;
+  }
+  return table;
+}();
+
+inline TokenType find(std::string_view word) {
+  if (word.size() < MIN_LENGTH || word.size() > MAX_LENGTH) {
+    return TokenType::Identifier;
+  }
+
+  const Keyword &keyword = table[hash(word, seed)];
+  return keyword.spelling == word ? keyword.type : TokenType::Identifier;
+}
+} // namespace Keywords
+
+#endif
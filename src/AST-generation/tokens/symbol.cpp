@@ -0,0 +1,40 @@
+#include "symbol.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+// Lets the table be searched with a `string_view`, a string is only built for
+// names that aren't in it yet.
+struct InternHash {
+  using is_transparent = void;
+  inline size_t operator()(std::string_view string) const {
+    return std::hash<std::string_view>()(string);
+  }
+};
+
+// Built on first use rather than at static initialization, so that symbols
+// can be interned from other static initializers.
+static std::unordered_set<std::string, InternHash, std::equal_to<>> &table() {
+  static std::unordered_set<std::string, InternHash, std::equal_to<>> strings;
+  return strings;
+}
+
+const Symbol Symbol::initName = Symbol::intern("init");
+const Symbol Symbol::thisName = Symbol::intern("this");
+const Symbol Symbol::superName = Symbol::intern("super");
+
+// Imported files are lexed on several threads at once.
+static std::mutex tableMutex;
+
+Symbol Symbol::intern(std::string_view name) {
+  auto &strings = table();
+  std::lock_guard<std::mutex> lock(tableMutex);
+
+  auto it = strings.find(name);
+  if (it == strings.end()) {
+    it = strings.emplace(name).first;
+  }
+
+  // Nodes of an unordered_set never move, the address is the symbol.
+  return Symbol(&*it);
+}
@@ -0,0 +1,43 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// An interned string. Identifiers, string literals and field names are
+// interned as they are lexed, so a name is always the same symbol and
+// comparing or hashing one only looks at a pointer. Symbols are never freed.
+class Symbol {
+private:
+  const std::string *string;
+
+  explicit Symbol(const std::string *string) : string(string) {}
+
+  friend struct std::hash<Symbol>;
+
+public:
+  // Names the language gives a meaning to.
+  static const Symbol initName, thisName, superName;
+
+public:
+  // Left uninitialized, tokens keep a symbol in a union and have to stay
+  // trivial.
+  Symbol() = default;
+
+  static Symbol intern(std::string_view);
+
+  inline const std::string &str() const { return *string; }
+  inline bool operator==(const Symbol &other) const {
+    return string == other.string;
+  }
+};
+
+template <> struct std::hash<Symbol> {
+  inline size_t operator()(const Symbol &symbol) const {
+    return std::hash<const std::string *>()(symbol.string);
+  }
+};
+
+#endif
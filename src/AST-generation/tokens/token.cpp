@@ -1,22 +1,67 @@
 #include "token.hpp"
+
+#include <deque>
 #include <iomanip>
+#include <mutex>
+#include <string>
+
+namespace SourceFiles {
+// A deque so that the names handed out stay valid as files are added.
+static std::deque<std::string> paths;
+// Imported files are lexed on several threads at once.
+static std::mutex pathsMutex;
+
+uint16_t intern(const char *path) {
+  std::lock_guard<std::mutex> lock(pathsMutex);
+  for (size_t file = 0; file < paths.size(); file++) {
+    if (paths[file] == path) {
+      return file;
+    }
+  }
 
-std::ostream &operator<<(std::ostream &os, const Token tk) {
+  paths.emplace_back(path);
+  return paths.size() - 1;
+}
+
+const char *name(uint16_t file) {
+  std::lock_guard<std::mutex> lock(pathsMutex);
+  return paths[file].c_str();
+}
+} // namespace SourceFiles
+
+Token *TokenArena::allocate(TokenType type, uint16_t file, int32_t line,
+                            int32_t column) {
+  if (used == BLOCK_SIZE) {
+    blocks.push_back(std::make_unique_for_overwrite<Token[]>(BLOCK_SIZE));
+    used = 0;
+  }
+
+  Token *token = &blocks.back()[used++];
+  token->type = type;
+  token->file = file;
+  token->line = line;
+  token->column = column;
+  return token;
+}
+
+std::ostream &operator<<(std::ostream &os, const Token &tk) {
   os << "Token { line: " << tk.line << ", column: " << tk.column
-     << ", filename: " << tk.filename << ", type: " << type2str(tk.type);
-  if (!std::holds_alternative<std::nullptr_t>(tk.lexeme)) {
-    os << ", lexeme: ";
-    std::visit(
-        [&](auto &&arg) {
-          using T = std::decay_t<decltype(arg)>;
-          if constexpr (std::is_same_v<T, int32_t> ||
-                        std::is_same_v<T, float> || std::is_same_v<T, char>) {
-            os << arg;
-          } else if constexpr (std::is_same_v<T, const char *>) {
-            os << std::quoted(arg);
-          }
-        },
-        tk.lexeme);
+     << ", filename: " << tk.filename() << ", type: " << type2str(tk.type);
+
+  switch (tk.type) {
+  case TokenType::Number:
+    os << ", lexeme: " << tk.number;
+    break;
+  case TokenType::Char:
+    os << ", lexeme: " << tk.character;
+    break;
+  case TokenType::Identifier:
+  case TokenType::String:
+  case TokenType::Error:
+    os << ", lexeme: " << std::quoted(tk.lexeme());
+    break;
+  default:
+    break;
   }
 
   os << " }";
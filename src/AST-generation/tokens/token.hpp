@@ -1,30 +1,80 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include "symbol.hpp"
 #include "token_type.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <ostream>
-#include <variant>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
-using literal_t =
-    std::variant<const char *, char, int32_t, float, std::nullptr_t>;
-
-struct Token {
-  Token(TokenType type, literal_t lexeme, int32_t line, int32_t column,
-        const char *filename)
-      : type(type), lexeme(lexeme), line(line), column(column),
-        filename(filename) {}
+struct SourceLocation {
+  int line;
+  int column;
+  const char *filename;
+};
 
-public:
+// Where the lexer was in a file, so that it can pick up from there later.
+struct SourcePosition {
+  uint16_t file;
+  uint32_t offset;
   int32_t line;
   int32_t column;
+};
+
+// Paths of the files that have been lexed, tokens refer to their file by its
+// index in this table.
+namespace SourceFiles {
+uint16_t intern(const char *path);
+const char *name(uint16_t file);
+} // namespace SourceFiles
+
+// Plain data, tokens are allocated in bulk by a `TokenArena` and AST nodes
+// point into it. The text of identifiers, strings and errors is interned,
+// numbers and chars are stored in the token itself.
+struct Token {
   TokenType type;
-  literal_t lexeme;
-  const char *filename;
+  uint16_t file;
+  int32_t line;
+  int32_t column;
+  union {
+    Symbol symbol;
+    float number;
+    char character;
+  };
+
+  inline std::string_view lexeme() const { return symbol.str(); }
+  inline const char *filename() const { return SourceFiles::name(file); }
+  inline SourceLocation location() const { return {line, column, filename()}; }
+};
+
+static_assert(sizeof(Token) == 24);
+static_assert(std::is_trivially_copyable_v<Token>);
+
+// Tokens of one source file. They are allocated in blocks that are only freed
+// with the arena, so a token never moves once it has been made.
+class TokenArena {
+private:
+  static constexpr size_t BLOCK_SIZE = 4096;
+
+  std::vector<std::unique_ptr<Token[]>> blocks;
+  size_t used;
+
+public:
+  TokenArena() : blocks(), used(BLOCK_SIZE) {}
+  TokenArena(const TokenArena &) = delete;
+
+  Token *allocate(TokenType type, uint16_t file, int32_t line, int32_t column);
+
+  inline size_t size() const {
+    return blocks.empty() ? 0 : (blocks.size() - 1) * BLOCK_SIZE + used;
+  }
 };
 
-std::ostream &operator<<(std::ostream &os, const Token tk);
+std::ostream &operator<<(std::ostream &os, const Token &tk);
 
 #endif
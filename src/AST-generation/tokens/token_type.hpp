@@ -3,11 +3,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <utility>
 
-enum class TokenType {
+enum class TokenType : uint8_t {
   // Single-character tokens.
   LeftParen,
   RightParen,
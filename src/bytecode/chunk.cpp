@@ -0,0 +1,34 @@
+#include "chunk.hpp"
+
+#include <algorithm>
+
+size_t Chunk::addConstant(const Value &value) {
+  auto it = std::find(constants.begin(), constants.end(), value);
+  if (it != constants.end()) {
+    return it - constants.begin();
+  }
+
+  constants.push_back(value);
+  return constants.size() - 1;
+}
+
+size_t Chunk::addName(Symbol name) {
+  auto it = std::find(names.begin(), names.end(), name);
+  if (it != names.end()) {
+    return it - names.begin();
+  }
+
+  names.push_back(name);
+  return names.size() - 1;
+}
+
+size_t Chunk::addFunction(std::shared_ptr<FnPrototype> &function) {
+  functions.push_back(function);
+  return functions.size() - 1;
+}
+
+size_t Chunk::addCache(size_t offset) {
+  caches.emplace_back();
+  cacheOffsets.push_back(offset);
+  return caches.size() - 1;
+}
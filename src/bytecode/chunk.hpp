@@ -0,0 +1,66 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include "../AST-generation/tokens/symbol.hpp"
+#include "../interpretation/inline_cache.hpp"
+#include "../interpretation/runtime_error.hpp"
+#include "../interpretation/types/LBPLTypes.hpp"
+#include "opcodes.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct FnPrototype;
+
+struct Chunk {
+  std::vector<uint8_t> code;
+  // One entry per byte of `code`, used to locate runtime errors.
+  std::vector<SourceLocation> locations;
+  std::vector<Value> constants;
+  std::vector<Symbol> names;
+  std::vector<std::shared_ptr<FnPrototype>> functions;
+  // Caches of the field and method instructions, along with the offset of
+  // the instruction each one belongs to.
+  std::vector<InlineCache> caches;
+  std::vector<size_t> cacheOffsets;
+
+  void write(uint8_t byte, const SourceLocation &location) {
+    code.push_back(byte);
+    locations.push_back(location);
+  }
+
+  void write(OpCode op, const SourceLocation &location) {
+    write(static_cast<uint8_t>(op), location);
+  }
+
+  void writeShort(uint16_t value, const SourceLocation &location) {
+    write(static_cast<uint8_t>(value >> 8), location);
+    write(static_cast<uint8_t>(value & 0xff), location);
+  }
+
+  size_t addConstant(const Value &value);
+  size_t addName(Symbol name);
+  size_t addFunction(std::shared_ptr<FnPrototype> &function);
+  size_t addCache(size_t offset);
+};
+
+// A top-level function the parser skimmed is `deferred`, its chunk stays
+// empty until it's first called. `maxStack` is the most values its frame
+// ever holds, locals included.
+struct FnPrototype {
+  std::string name;
+  int arity;
+  int upvalueCount;
+  int maxStack;
+  Chunk chunk;
+  std::optional<SourcePosition> deferred;
+
+  FnPrototype(const std::string &name, int arity)
+      : name(name), arity(arity), upvalueCount(0), maxStack(0), chunk(),
+        deferred() {}
+};
+
+#endif
@@ -0,0 +1,777 @@
+#include "compiler.hpp"
+#include "../AST-generation/syntax_error.hpp"
+#include "../interpretation/heap.hpp"
+#include "../interpretation/types/LBPLString.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+#define MAX_LOCALS (UINT8_MAX + 1)
+#define MAX_UPVALUES (UINT8_MAX + 1)
+
+std::shared_ptr<FnPrototype> Compiler::compile(std::span<Stmt *> stmts) {
+  FunctionState script = {
+      .enclosing = nullptr,
+      .proto = std::make_shared<FnPrototype>("script", 0),
+      .type = FunctionType::None,
+      .locals = {},
+      .upvalues = {},
+      .loops = {},
+      .scopeDepth = 0,
+      .stackDepth = 0,
+  };
+  script.locals.push_back({Symbol::intern(""), 0, false});
+  current = &script;
+  changeStack(1);
+
+  for (auto &&stmt : stmts) {
+    try {
+      stmt->accept(this);
+    } catch (SyntaxError &e) {
+      std::cout << e.what();
+      hadError = true;
+
+      current = &script;
+      currentClass = nullptr;
+      script.scopeDepth = 0;
+      script.locals.resize(1);
+      script.loops.clear();
+      script.stackDepth = 1;
+    }
+  }
+
+  emitReturn();
+  current = nullptr;
+  return script.proto;
+}
+
+void Compiler::compileDeferred(FnStmt *stmt,
+                               const std::shared_ptr<FnPrototype> &proto) {
+  FunctionState state = {
+      .enclosing = nullptr,
+      .proto = proto,
+      .type = FunctionType::Function,
+      .locals = {},
+      .upvalues = {},
+      .loops = {},
+      .scopeDepth = 0,
+      .stackDepth = 0,
+  };
+
+  try {
+    functionBody(state, stmt);
+  } catch (SyntaxError &e) {
+    std::cout << e.what();
+    hadError = true;
+  }
+
+  current = nullptr;
+}
+
+void Compiler::setLocation(Expr *expr) {
+  location = expr->location->location();
+}
+
+void Compiler::setLocation(Stmt *stmt) {
+  location = stmt->location->location();
+}
+
+// How many values `op` pushes minus how many it pops. Calls also pop their
+// arguments, their count is only known where they're emitted.
+static int stackEffect(OpCode op) {
+  switch (op) {
+  case OpCode::Constant:
+  case OpCode::Nil:
+  case OpCode::True:
+  case OpCode::False:
+  case OpCode::GetLocal:
+  case OpCode::GetGlobal:
+  case OpCode::GetUpvalue:
+  case OpCode::Closure:
+  case OpCode::Class:
+    return 1;
+  case OpCode::Pop:
+  case OpCode::DefineGlobal:
+  case OpCode::SetField:
+  case OpCode::GetSuper:
+  case OpCode::Equal:
+  case OpCode::NotEqual:
+  case OpCode::Greater:
+  case OpCode::GreaterEqual:
+  case OpCode::Less:
+  case OpCode::LessEqual:
+  case OpCode::Add:
+  case OpCode::Subtract:
+  case OpCode::Multiply:
+  case OpCode::Divide:
+  case OpCode::Modulo:
+  case OpCode::CloseUpvalue:
+  case OpCode::Return:
+  case OpCode::Inherit:
+  case OpCode::Method:
+    return -1;
+  default:
+    return 0;
+  }
+}
+
+void Compiler::emit(OpCode op) {
+  chunk().write(op, location);
+  changeStack(stackEffect(op));
+}
+
+void Compiler::emit(OpCode op, uint8_t operand) {
+  emit(op);
+  chunk().write(operand, location);
+}
+
+void Compiler::emitShort(OpCode op, uint16_t operand) {
+  emit(op);
+  chunk().writeShort(operand, location);
+}
+
+// Emits an instruction taking a name followed by its own inline cache.
+void Compiler::emitCached(OpCode op, Symbol name) {
+  size_t offset = chunk().code.size();
+  emitShort(op, makeName(name));
+
+  size_t cache = chunk().addCache(offset);
+  if (cache > UINT16_MAX) {
+    throw SyntaxError(location, "Too many field accesses in one function.");
+  }
+  chunk().writeShort(cache, location);
+}
+
+void Compiler::emitConstant(const Value &value) {
+  size_t index = chunk().addConstant(value);
+  if (index > UINT16_MAX) {
+    throw SyntaxError(location, "Too many constants in one function.");
+  }
+
+  emitShort(OpCode::Constant, index);
+}
+
+void Compiler::emitReturn() {
+  if (current->type == FunctionType::Initializer) {
+    emit(OpCode::GetLocal, 0);
+  } else {
+    emit(OpCode::Nil);
+  }
+
+  emit(OpCode::Return);
+}
+
+void Compiler::changeStack(int delta) {
+  current->stackDepth += delta;
+  current->proto->maxStack =
+      std::max(current->proto->maxStack, current->stackDepth);
+}
+
+size_t Compiler::emitJump(OpCode op) {
+  emitShort(op, UINT16_MAX);
+  return chunk().code.size() - 2;
+}
+
+void Compiler::emitLoop(size_t loopStart) {
+  emit(OpCode::Loop);
+
+  size_t offset = chunk().code.size() - loopStart + 2;
+  if (offset > UINT16_MAX) {
+    throw SyntaxError(location, "Loop body too large.");
+  }
+
+  chunk().writeShort(offset, location);
+}
+
+void Compiler::patchJump(size_t offset) {
+  size_t jump = chunk().code.size() - offset - 2;
+  if (jump > UINT16_MAX) {
+    throw SyntaxError(location, "Too much code to jump over.");
+  }
+
+  chunk().code[offset] = (jump >> 8) & 0xff;
+  chunk().code[offset + 1] = jump & 0xff;
+}
+
+uint16_t Compiler::makeName(Symbol name) {
+  size_t index = chunk().addName(name);
+  if (index > UINT16_MAX) {
+    throw SyntaxError(location, "Too many names in one function.");
+  }
+
+  return index;
+}
+
+void Compiler::beginScope() { current->scopeDepth++; }
+
+void Compiler::endScope() {
+  current->scopeDepth--;
+
+  while (!current->locals.empty() &&
+         current->locals.back().depth > current->scopeDepth) {
+    emit(current->locals.back().isCaptured ? OpCode::CloseUpvalue
+                                           : OpCode::Pop);
+    current->locals.pop_back();
+  }
+}
+
+void Compiler::popLocalsAbove(int depth) {
+  for (int i = current->locals.size() - 1;
+       i >= 0 && current->locals[i].depth > depth; i--) {
+    emit(current->locals[i].isCaptured ? OpCode::CloseUpvalue : OpCode::Pop);
+  }
+}
+
+void Compiler::addLocal(Symbol name) {
+  if (current->locals.size() == MAX_LOCALS) {
+    throw SyntaxError(location, "Too many local variables in function.");
+  }
+
+  current->locals.push_back({name, -1, false});
+}
+
+void Compiler::markInitialized() {
+  if (current->scopeDepth == 0) {
+    return;
+  }
+
+  current->locals.back().depth = current->scopeDepth;
+}
+
+int Compiler::resolveLocal(FunctionState *state, Symbol name) {
+  for (int i = state->locals.size() - 1; i >= 0; i--) {
+    if (state->locals[i].name == name) {
+      if (state->locals[i].depth == -1) {
+        throw SyntaxError(location,
+                          "You are trying to read the value of a variable "
+                          "that hasn't been defined yet.");
+      }
+
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+int Compiler::resolveUpvalue(FunctionState *state, Symbol name) {
+  if (!state->enclosing) {
+    return -1;
+  }
+
+  if (int local = resolveLocal(state->enclosing, name); local != -1) {
+    state->enclosing->locals[local].isCaptured = true;
+    return addUpvalue(state, local, true);
+  }
+
+  if (int upvalue = resolveUpvalue(state->enclosing, name); upvalue != -1) {
+    return addUpvalue(state, upvalue, false);
+  }
+
+  return -1;
+}
+
+int Compiler::addUpvalue(FunctionState *state, uint8_t index, bool isLocal) {
+  for (size_t i = 0; i < state->upvalues.size(); i++) {
+    if (state->upvalues[i].index == index &&
+        state->upvalues[i].isLocal == isLocal) {
+      return i;
+    }
+  }
+
+  if (state->upvalues.size() == MAX_UPVALUES) {
+    throw SyntaxError(location, "Too many closure variables in function.");
+  }
+
+  state->upvalues.push_back({index, isLocal});
+  return state->upvalues.size() - 1;
+}
+
+void Compiler::declareVariable(Symbol name) {
+  if (current->scopeDepth == 0) {
+    return;
+  }
+
+  addLocal(name);
+}
+
+void Compiler::defineVariable(Symbol name) {
+  if (current->scopeDepth > 0) {
+    markInitialized();
+    return;
+  }
+
+  emitShort(OpCode::DefineGlobal, vm.globalSlot(name));
+}
+
+void Compiler::namedVariable(Symbol name, bool assign) {
+  if (int slot = resolveLocal(current, name); slot != -1) {
+    emit(assign ? OpCode::SetLocal : OpCode::GetLocal, slot);
+  } else if (int upvalue = resolveUpvalue(current, name); upvalue != -1) {
+    emit(assign ? OpCode::SetUpvalue : OpCode::GetUpvalue, upvalue);
+  } else {
+    emitShort(assign ? OpCode::SetGlobal : OpCode::GetGlobal,
+              vm.globalSlot(name));
+  }
+}
+
+void Compiler::function(FnStmt *stmt, FunctionType::Type type) {
+  FunctionState state = {
+      .enclosing = current,
+      .proto = std::make_shared<FnPrototype>(stmt->name->symbol.str(),
+                                             stmt->args.size()),
+      .type = type,
+      .locals = {},
+      .upvalues = {},
+      .loops = {},
+      .scopeDepth = 0,
+      .stackDepth = 0,
+  };
+
+  // Compiled by the VM the first time it's called.
+  if (stmt->deferred) {
+    state.proto->deferred = stmt->deferred->position;
+  } else {
+    functionBody(state, stmt);
+  }
+
+  current = state.enclosing;
+  setLocation(stmt);
+
+  state.proto->upvalueCount = state.upvalues.size();
+  emitShort(OpCode::Closure, chunk().addFunction(state.proto));
+  for (auto &&upvalue : state.upvalues) {
+    chunk().write(upvalue.isLocal ? 1 : 0, location);
+    chunk().write(upvalue.index, location);
+  }
+}
+
+void Compiler::functionBody(FunctionState &state, FnStmt *stmt) {
+  state.locals.push_back({state.type == FunctionType::Function
+                              ? Symbol::intern("")
+                              : Symbol::thisName,
+                          0, false});
+  current = &state;
+
+  beginScope();
+  for (auto &&arg : stmt->args) {
+    addLocal(arg->symbol);
+    markInitialized();
+  }
+  changeStack(state.locals.size());
+
+  compileBody(stmt->body);
+  emitReturn();
+}
+
+void Compiler::compileBody(std::span<Stmt *> body) {
+  for (auto &&stmt : body) {
+    stmt->accept(this);
+  }
+}
+
+void Compiler::visitFnStmt(FnStmt *stmt) {
+  setLocation(stmt);
+  Symbol name = stmt->name->symbol;
+
+  declareVariable(name);
+  markInitialized();
+  function(stmt, FunctionType::Function);
+  defineVariable(name);
+}
+
+void Compiler::visitVarStmt(VarStmt *stmt) {
+  setLocation(stmt);
+  Symbol name = stmt->name->symbol;
+
+  declareVariable(name);
+  if (stmt->value) {
+    stmt->value->accept(this);
+  } else {
+    emit(OpCode::Nil);
+  }
+
+  setLocation(stmt);
+  defineVariable(name);
+}
+
+void Compiler::visitClassStmt(ClassStmt *stmt) {
+  setLocation(stmt);
+  Symbol name = stmt->name->symbol;
+  uint16_t nameIndex = makeName(name);
+
+  declareVariable(name);
+  emitShort(OpCode::Class, nameIndex);
+  defineVariable(name);
+
+  ClassState classState = {currentClass, false};
+  currentClass = &classState;
+
+  if (stmt->superclass) {
+    setLocation(stmt->superclass);
+    namedVariable(stmt->superclass->variable->symbol, false);
+
+    beginScope();
+    addLocal(Symbol::superName);
+    markInitialized();
+
+    namedVariable(name, false);
+    emit(OpCode::Inherit);
+    classState.hasSuperclass = true;
+  }
+
+  namedVariable(name, false);
+  for (auto &&methodStmt : stmt->body) {
+    auto method = dynamic_cast<FnStmt *>(methodStmt);
+    if (!method) {
+      throw SyntaxError(methodStmt, "Excepted class method.");
+    }
+
+    Symbol methodName = method->name->symbol;
+    function(method, methodName == Symbol::initName ? FunctionType::Initializer
+                                                    : FunctionType::Method);
+    emitShort(OpCode::Method, makeName(methodName));
+  }
+  emit(OpCode::Pop);
+
+  if (classState.hasSuperclass) {
+    endScope();
+  }
+
+  currentClass = classState.enclosing;
+}
+
+void Compiler::visitIfStmt(IfStmt *stmt) {
+  stmt->condition->accept(this);
+
+  setLocation(stmt);
+  size_t thenJump = emitJump(OpCode::JumpIfFalse);
+  int depth = current->stackDepth;
+  emit(OpCode::Pop);
+  stmt->trueBranch->accept(this);
+
+  size_t elseJump = emitJump(OpCode::Jump);
+  patchJump(thenJump);
+  current->stackDepth = depth;
+  emit(OpCode::Pop);
+
+  if (stmt->falseBranch) {
+    stmt->falseBranch->accept(this);
+  }
+  patchJump(elseJump);
+}
+
+void Compiler::visitWhileStmt(WhileStmt *stmt) {
+  size_t loopStart = chunk().code.size();
+  stmt->condition->accept(this);
+
+  setLocation(stmt);
+  size_t exitJump = emitJump(OpCode::JumpIfFalse);
+  int depth = current->stackDepth;
+  emit(OpCode::Pop);
+
+  current->loops.push_back({.scopeDepth = current->scopeDepth,
+                            .continueTarget = (int64_t)loopStart,
+                            .continueJumps = {},
+                            .breakJumps = {}});
+  stmt->body->accept(this);
+  emitLoop(loopStart);
+
+  patchJump(exitJump);
+  current->stackDepth = depth;
+  emit(OpCode::Pop);
+
+  for (auto &&jump : current->loops.back().breakJumps) {
+    patchJump(jump);
+  }
+  current->loops.pop_back();
+}
+
+void Compiler::visitForStmt(ForStmt *stmt) {
+  beginScope();
+  if (stmt->initializer) {
+    stmt->initializer->accept(this);
+  }
+
+  size_t loopStart = chunk().code.size();
+  stmt->condition->accept(this);
+
+  setLocation(stmt);
+  size_t exitJump = emitJump(OpCode::JumpIfFalse);
+  int depth = current->stackDepth;
+  emit(OpCode::Pop);
+
+  current->loops.push_back({.scopeDepth = current->scopeDepth,
+                            .continueTarget = -1,
+                            .continueJumps = {},
+                            .breakJumps = {}});
+  stmt->body->accept(this);
+
+  for (auto &&jump : current->loops.back().continueJumps) {
+    patchJump(jump);
+  }
+
+  if (stmt->increment) {
+    stmt->increment->accept(this);
+    emit(OpCode::Pop);
+  }
+  emitLoop(loopStart);
+
+  patchJump(exitJump);
+  current->stackDepth = depth;
+  emit(OpCode::Pop);
+
+  for (auto &&jump : current->loops.back().breakJumps) {
+    patchJump(jump);
+  }
+  current->loops.pop_back();
+  endScope();
+}
+
+void Compiler::visitScopedStmt(ScopedStmt *stmt) {
+  beginScope();
+  compileBody(stmt->body);
+  endScope();
+}
+
+void Compiler::visitExprStmt(ExprStmt *stmt) {
+  stmt->expr->accept(this);
+  emit(OpCode::Pop);
+}
+
+void Compiler::visitReturnStmt(ReturnStmt *stmt) {
+  setLocation(stmt);
+
+  if (stmt->value) {
+    stmt->value->accept(this);
+    emit(OpCode::Return);
+  } else {
+    emitReturn();
+  }
+}
+
+Value Compiler::visitBinaryExpr(BinaryExpr *expr) {
+  if (expr->op->type == TokenType::And) {
+    expr->left->accept(this);
+    size_t endJump = emitJump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+    expr->right->accept(this);
+    patchJump(endJump);
+    return nullptr;
+  } else if (expr->op->type == TokenType::Or) {
+    expr->left->accept(this);
+    size_t elseJump = emitJump(OpCode::JumpIfFalse);
+    size_t endJump = emitJump(OpCode::Jump);
+    patchJump(elseJump);
+    emit(OpCode::Pop);
+    expr->right->accept(this);
+    patchJump(endJump);
+    return nullptr;
+  }
+
+  expr->left->accept(this);
+  expr->right->accept(this);
+
+  location = {expr->op->line, expr->op->column, expr->op->filename()};
+  switch (expr->op->type) {
+  case TokenType::Plus:
+    emit(OpCode::Add);
+    break;
+  case TokenType::Minus:
+    emit(OpCode::Subtract);
+    break;
+  case TokenType::Star:
+    emit(OpCode::Multiply);
+    break;
+  case TokenType::Slash:
+    emit(OpCode::Divide);
+    break;
+  case TokenType::ModOp:
+    emit(OpCode::Modulo);
+    break;
+  case TokenType::EqualEqual:
+    emit(OpCode::Equal);
+    break;
+  case TokenType::BangEqual:
+    emit(OpCode::NotEqual);
+    break;
+  case TokenType::Greater:
+    emit(OpCode::Greater);
+    break;
+  case TokenType::GreaterEqual:
+    emit(OpCode::GreaterEqual);
+    break;
+  case TokenType::Less:
+    emit(OpCode::Less);
+    break;
+  case TokenType::LessEqual:
+    emit(OpCode::LessEqual);
+    break;
+  default:
+    throw SyntaxError(expr->op, "Unsupported binary operation.");
+  }
+
+  return nullptr;
+}
+
+Value Compiler::visitBreakExpr(BreakExpr *expr) {
+  setLocation(expr);
+  if (current->loops.empty()) {
+    throw SyntaxError(expr, "Can't break from outside of a loop.");
+  }
+
+  // The code that follows runs with the locals that were popped.
+  int depth = current->stackDepth;
+  popLocalsAbove(current->loops.back().scopeDepth);
+  current->loops.back().breakJumps.push_back(emitJump(OpCode::Jump));
+  current->stackDepth = depth;
+  return nullptr;
+}
+
+Value Compiler::visitContinueExpr(ContinueExpr *expr) {
+  setLocation(expr);
+  if (current->loops.empty()) {
+    throw SyntaxError(expr, "Can't continue from outside of a loop.");
+  }
+
+  Loop &loop = current->loops.back();
+  int depth = current->stackDepth;
+  popLocalsAbove(loop.scopeDepth);
+
+  if (loop.continueTarget >= 0) {
+    emitLoop(loop.continueTarget);
+  } else {
+    loop.continueJumps.push_back(emitJump(OpCode::Jump));
+  }
+  current->stackDepth = depth;
+  return nullptr;
+}
+
+Value Compiler::visitUnaryExpr(UnaryExpr *expr) {
+  expr->right->accept(this);
+
+  setLocation(expr);
+  emit(expr->op->type == TokenType::Minus ? OpCode::Negate : OpCode::Not);
+  return nullptr;
+}
+
+Value Compiler::visitLiteralExpr(LiteralExpr *expr) {
+  setLocation(expr);
+
+  if (expr->string) {
+    emitConstant(heap.literal(*expr->string));
+  } else if (expr->value.isBool()) {
+    emit(expr->value.asBool() ? OpCode::True : OpCode::False);
+  } else if (expr->value.isNil()) {
+    emit(OpCode::Nil);
+  } else {
+    emitConstant(expr->value);
+  }
+
+  return nullptr;
+}
+
+Value Compiler::visitGroupExpr(GroupingExpr *expr) {
+  expr->expr->accept(this);
+  return nullptr;
+}
+
+Value Compiler::visitSuperExpr(SuperExpr *expr) {
+  setLocation(expr);
+  if (!currentClass || !currentClass->hasSuperclass) {
+    throw SyntaxError(expr,
+                      "Can't access 'super' in a class without superclass.");
+  }
+
+  namedVariable(Symbol::thisName, false);
+  namedVariable(Symbol::superName, false);
+  emitShort(OpCode::GetSuper, makeName(expr->field->symbol));
+  return nullptr;
+}
+
+Value Compiler::visitThisExpr(ThisExpr *expr) {
+  setLocation(expr);
+  namedVariable(Symbol::thisName, false);
+  return nullptr;
+}
+
+Value Compiler::visitCallExpr(FnCallExpr *expr) {
+  if (expr->args.size() > UINT8_MAX) {
+    throw SyntaxError(expr, "Can't have more than 255 arguments.");
+  }
+
+  auto method = dynamic_cast<GetFieldExpr *>(expr->callee);
+  if (method) {
+    method->instance->accept(this);
+  } else {
+    expr->callee->accept(this);
+  }
+
+  for (auto &&arg : expr->args) {
+    arg->accept(this);
+  }
+
+  setLocation(expr->callee);
+  if (method) {
+    emitCached(expr->isTailCall ? OpCode::TailInvoke : OpCode::Invoke,
+               method->field->symbol);
+    chunk().write(static_cast<uint8_t>(expr->args.size()), location);
+  } else {
+    emit(expr->isTailCall ? OpCode::TailCall : OpCode::Call,
+         expr->args.size());
+  }
+  // The result takes the place of the callee.
+  changeStack(-static_cast<int>(expr->args.size()));
+
+  return nullptr;
+}
+
+Value Compiler::visitGetFieldExpr(GetFieldExpr *expr) {
+  expr->instance->accept(this);
+
+  setLocation(expr);
+  emitCached(OpCode::GetField, expr->field->symbol);
+  return nullptr;
+}
+
+Value Compiler::visitSetFieldExpr(SetFieldExpr *expr) {
+  expr->instance->accept(this);
+  expr->value->accept(this);
+
+  setLocation(expr);
+  emitCached(OpCode::SetField, expr->field->symbol);
+  return nullptr;
+}
+
+Value Compiler::visitTernaryExpr(TernaryExpr *expr) {
+  expr->condition->accept(this);
+
+  setLocation(expr);
+  size_t elseJump = emitJump(OpCode::JumpIfFalse);
+  emit(OpCode::Pop);
+  expr->trueBranch->accept(this);
+
+  size_t endJump = emitJump(OpCode::Jump);
+  patchJump(elseJump);
+  emit(OpCode::Pop);
+  expr->falseBranch->accept(this);
+  patchJump(endJump);
+
+  return nullptr;
+}
+
+Value Compiler::visitVarExpr(VariableExpr *expr) {
+  setLocation(expr);
+  namedVariable(expr->variable->symbol, false);
+  return nullptr;
+}
+
+Value Compiler::visitAssignExpr(AssignExpr *expr) {
+  expr->value->accept(this);
+
+  setLocation(expr);
+  namedVariable(expr->variable->symbol, true);
+  return nullptr;
+}
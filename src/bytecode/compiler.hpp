@@ -0,0 +1,138 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "../AST-generation/statements.hpp"
+#include "../interpretation/resolver.hpp"
+#include "../interpretation/visitor.hpp"
+#include "chunk.hpp"
+#include "vm.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Lowers a resolved AST into bytecode for the VM. Locals live in stack slots,
+// variables captured by inner functions are turned into upvalues and every
+// top-level name gets a global slot in the VM.
+class Compiler : Statement::Visitor, Expression::Visitor {
+private:
+  struct Local {
+    Symbol name;
+    int depth;
+    bool isCaptured;
+  };
+
+  struct Upvalue {
+    uint8_t index;
+    bool isLocal;
+  };
+
+  struct Loop {
+    int scopeDepth;
+    // Backward target of `continue`, `for` loops jump forward to their
+    // increment instead so they collect the jumps to patch in
+    // `continueJumps`.
+    int64_t continueTarget;
+    std::vector<size_t> continueJumps;
+    std::vector<size_t> breakJumps;
+  };
+
+  struct FunctionState {
+    FunctionState *enclosing;
+    std::shared_ptr<FnPrototype> proto;
+    FunctionType::Type type;
+    std::vector<Local> locals;
+    std::vector<Upvalue> upvalues;
+    std::vector<Loop> loops;
+    int scopeDepth;
+    // Values on the stack at this point of the code, locals included.
+    int stackDepth;
+  };
+
+  struct ClassState {
+    ClassState *enclosing;
+    bool hasSuperclass;
+  };
+
+  VM &vm;
+  FunctionState *current;
+  ClassState *currentClass;
+  SourceLocation location;
+
+public:
+  bool hadError;
+
+private:
+  inline Chunk &chunk() { return current->proto->chunk; }
+
+  void emit(OpCode);
+  void emit(OpCode, uint8_t);
+  void emitShort(OpCode, uint16_t);
+  void emitCached(OpCode, Symbol name);
+  void emitConstant(const Value &);
+  void emitReturn();
+  void changeStack(int delta);
+  size_t emitJump(OpCode);
+  void emitLoop(size_t loopStart);
+  void patchJump(size_t offset);
+
+  uint16_t makeName(Symbol);
+
+  void beginScope();
+  void endScope();
+  void popLocalsAbove(int depth);
+
+  void addLocal(Symbol);
+  void markInitialized();
+  int resolveLocal(FunctionState *, Symbol);
+  int resolveUpvalue(FunctionState *, Symbol);
+  int addUpvalue(FunctionState *, uint8_t index, bool isLocal);
+
+  void declareVariable(Symbol);
+  void defineVariable(Symbol);
+  void namedVariable(Symbol, bool assign);
+
+  void function(FnStmt *, FunctionType::Type);
+  void functionBody(FunctionState &, FnStmt *);
+  void compileBody(std::span<Stmt *>);
+  void setLocation(Expr *);
+  void setLocation(Stmt *);
+
+  void visitFnStmt(FnStmt *) override;
+  void visitVarStmt(VarStmt *) override;
+  void visitClassStmt(ClassStmt *) override;
+  void visitIfStmt(IfStmt *) override;
+  void visitWhileStmt(WhileStmt *) override;
+  void visitForStmt(ForStmt *) override;
+  void visitScopedStmt(ScopedStmt *) override;
+  void visitExprStmt(ExprStmt *) override;
+  void visitReturnStmt(ReturnStmt *) override;
+
+  Value visitBinaryExpr(BinaryExpr *) override;
+  Value visitBreakExpr(BreakExpr *) override;
+  Value visitContinueExpr(ContinueExpr *) override;
+  Value visitUnaryExpr(UnaryExpr *) override;
+  Value visitLiteralExpr(LiteralExpr *) override;
+  Value visitGroupExpr(GroupingExpr *) override;
+  Value visitSuperExpr(SuperExpr *) override;
+  Value visitThisExpr(ThisExpr *) override;
+  Value visitCallExpr(FnCallExpr *) override;
+  Value visitGetFieldExpr(GetFieldExpr *) override;
+  Value visitSetFieldExpr(SetFieldExpr *) override;
+  Value visitTernaryExpr(TernaryExpr *) override;
+  Value visitVarExpr(VariableExpr *) override;
+  Value visitAssignExpr(AssignExpr *) override;
+
+public:
+  Compiler(VM &vm)
+      : vm(vm), current(nullptr), currentClass(nullptr),
+        location({0, 0, ""}), hadError(false) {}
+
+  std::shared_ptr<FnPrototype> compile(std::span<Stmt *>);
+  // Compiles a deferred top-level function into the prototype made for it.
+  void compileDeferred(FnStmt *, const std::shared_ptr<FnPrototype> &);
+};
+
+#endif
@@ -0,0 +1,374 @@
+#include "module_cache.hpp"
+#include "../AST-generation/mapped_file.hpp"
+#include "../interpretation/heap.hpp"
+#include "../interpretation/types/LBPLString.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+
+// Layout of a cache file, every number in the byte order of the machine:
+//
+//   u32 magic, u32 version, u64 hash of everything that follows
+//   u32 count, then (string path, u64 hash) for each source file
+//   u32 count, then the name of each global in slot order
+//   u32 count, then the file name of each source location
+//   the script's prototype
+//
+// Strings are a u32 length followed by their bytes. A prototype is its name,
+// i32 arity, upvalue count and maximum stack size, a u8 set when it's
+// deferred followed then by where its body is (u32 file, u32 offset, i32
+// line, i32 column), its code, its source locations as runs of (u32 length,
+// i32 line, i32 column, u32 file), its constants, names and nested
+// prototypes, and the offsets of its inline caches.
+namespace ModuleCache {
+static constexpr uint32_t MAGIC = 0x43504c42; // "BLPC"
+
+namespace Constant {
+enum Tag : uint8_t {
+  Value,
+  String,
+};
+}
+
+// FNV-1a, unlike `std::hash` it's the same from one build to the next.
+static uint64_t fnv1a(const char *begin, const char *end) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const char *byte = begin; byte < end; byte++) {
+    hash = (hash ^ static_cast<uint8_t>(*byte)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+static bool hashFile(const char *path, uint64_t &hash) {
+  MappedFile file(path);
+  if (!file.loaded) {
+    return false;
+  }
+
+  hash = fnv1a(file.begin(), file.end());
+  return true;
+}
+
+struct Writer {
+  std::string out;
+  // File names the source locations refer to.
+  std::vector<const char *> locationFiles;
+
+  template <typename T> void put(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void putString(std::string_view string) {
+    put<uint32_t>(string.size());
+    out.append(string);
+  }
+
+  uint32_t locationFile(const char *filename) {
+    for (size_t i = 0; i < locationFiles.size(); i++) {
+      if (locationFiles[i] == filename) {
+        return i;
+      }
+    }
+
+    locationFiles.push_back(filename);
+    return locationFiles.size() - 1;
+  }
+};
+
+// Reads a cache file, `failed` is set as soon as something doesn't fit in
+// what's left of it.
+struct Reader {
+  const char *current, *end;
+  bool failed;
+
+  template <typename T> T get() {
+    T value{};
+    if (static_cast<size_t>(end - current) < sizeof(T)) {
+      failed = true;
+      return value;
+    }
+
+    std::memcpy(&value, current, sizeof(T));
+    current += sizeof(T);
+    return value;
+  }
+
+  std::string_view getString() {
+    uint32_t size = get<uint32_t>();
+    if (failed || static_cast<size_t>(end - current) < size) {
+      failed = true;
+      return {};
+    }
+
+    std::string_view string(current, size);
+    current += size;
+    return string;
+  }
+
+  // The length of a list of items at least `itemSize` bytes long each,
+  // checked against what's left before anything is allocated for it.
+  uint32_t getCount(size_t itemSize) {
+    uint32_t count = get<uint32_t>();
+    if (failed || count > (end - current) / itemSize) {
+      failed = true;
+      return 0;
+    }
+    return count;
+  }
+};
+
+// False when the prototype holds a constant that can't be cached.
+static bool writePrototype(Writer &writer, const FnPrototype &proto) {
+  const Chunk &chunk = proto.chunk;
+
+  writer.putString(proto.name);
+  writer.put<int32_t>(proto.arity);
+  writer.put<int32_t>(proto.upvalueCount);
+  writer.put<int32_t>(proto.maxStack);
+
+  writer.put<uint8_t>(proto.deferred.has_value());
+  if (const auto &position = proto.deferred) {
+    writer.put<uint32_t>(
+        writer.locationFile(SourceFiles::name(position->file)));
+    writer.put<uint32_t>(position->offset);
+    writer.put<int32_t>(position->line);
+    writer.put<int32_t>(position->column);
+  }
+
+  writer.put<uint32_t>(chunk.code.size());
+  writer.out.append(reinterpret_cast<const char *>(chunk.code.data()),
+                    chunk.code.size());
+
+  // Every byte of an instruction, and often whole statements, share the
+  // same location.
+  std::vector<std::pair<uint32_t, const SourceLocation *>> runs;
+  for (const SourceLocation &location : chunk.locations) {
+    if (!runs.empty() && runs.back().second->line == location.line &&
+        runs.back().second->column == location.column &&
+        runs.back().second->filename == location.filename) {
+      runs.back().first++;
+    } else {
+      runs.push_back({1, &location});
+    }
+  }
+
+  writer.put<uint32_t>(runs.size());
+  for (auto &&[length, location] : runs) {
+    writer.put<uint32_t>(length);
+    writer.put<int32_t>(location->line);
+    writer.put<int32_t>(location->column);
+    writer.put<uint32_t>(writer.locationFile(location->filename));
+  }
+
+  writer.put<uint32_t>(chunk.constants.size());
+  for (const Value &constant : chunk.constants) {
+    if (constant.isString()) {
+      writer.put<uint8_t>(Constant::String);
+      writer.putString(constant.as<LBPLString>()->str());
+    } else if (!constant.isObj()) {
+      writer.put<uint8_t>(Constant::Value);
+      writer.put(constant);
+    } else {
+      return false;
+    }
+  }
+
+  writer.put<uint32_t>(chunk.names.size());
+  for (Symbol name : chunk.names) {
+    writer.putString(name.str());
+  }
+
+  writer.put<uint32_t>(chunk.functions.size());
+  for (auto &&function : chunk.functions) {
+    if (!writePrototype(writer, *function)) {
+      return false;
+    }
+  }
+
+  writer.put<uint32_t>(chunk.cacheOffsets.size());
+  for (size_t offset : chunk.cacheOffsets) {
+    writer.put<uint32_t>(offset);
+  }
+
+  return true;
+}
+
+static std::shared_ptr<FnPrototype>
+readPrototype(Reader &reader, const std::vector<const char *> &files) {
+  std::string_view name = reader.getString();
+  int32_t arity = reader.get<int32_t>();
+  auto proto = std::make_shared<FnPrototype>(std::string(name), arity);
+  proto->upvalueCount = reader.get<int32_t>();
+  proto->maxStack = reader.get<int32_t>();
+  Chunk &chunk = proto->chunk;
+
+  if (reader.get<uint8_t>()) {
+    uint32_t file = reader.get<uint32_t>();
+    uint32_t offset = reader.get<uint32_t>();
+    int32_t line = reader.get<int32_t>();
+    int32_t column = reader.get<int32_t>();
+    if (reader.failed || file >= files.size()) {
+      return nullptr;
+    }
+
+    proto->deferred = {SourceFiles::intern(files[file]), offset, line, column};
+  }
+
+  uint32_t size = reader.getCount(1);
+  chunk.code.assign(reinterpret_cast<const uint8_t *>(reader.current),
+                    reinterpret_cast<const uint8_t *>(reader.current) + size);
+  reader.current += size;
+
+  for (uint32_t runs = reader.getCount(16); runs > 0; runs--) {
+    uint32_t length = reader.get<uint32_t>();
+    int32_t line = reader.get<int32_t>();
+    int32_t column = reader.get<int32_t>();
+    uint32_t file = reader.get<uint32_t>();
+    if (reader.failed || file >= files.size() ||
+        length > chunk.code.size() - chunk.locations.size()) {
+      return nullptr;
+    }
+
+    chunk.locations.insert(chunk.locations.end(), length,
+                           {line, column, files[file]});
+  }
+  if (chunk.locations.size() != chunk.code.size()) {
+    return nullptr;
+  }
+
+  for (uint32_t constants = reader.getCount(1); constants > 0; constants--) {
+    if (reader.get<uint8_t>() == Constant::String) {
+      chunk.constants.push_back(
+          heap.literal(Symbol::intern(reader.getString())));
+    } else {
+      chunk.constants.push_back(reader.get<Value>());
+    }
+  }
+
+  for (uint32_t names = reader.getCount(4); names > 0; names--) {
+    chunk.names.push_back(Symbol::intern(reader.getString()));
+  }
+
+  for (uint32_t functions = reader.getCount(4); functions > 0; functions--) {
+    std::shared_ptr<FnPrototype> function = readPrototype(reader, files);
+    if (!function) {
+      return nullptr;
+    }
+    chunk.functions.push_back(function);
+  }
+
+  for (uint32_t caches = reader.getCount(4); caches > 0; caches--) {
+    chunk.addCache(reader.get<uint32_t>());
+  }
+
+  return reader.failed ? nullptr : proto;
+}
+
+std::string path(const char *script) { return std::string(script) + "c"; }
+
+std::shared_ptr<FnPrototype> load(const char *script, VM &vm) {
+  MappedFile file(path(script).c_str());
+  if (!file.loaded) {
+    return nullptr;
+  }
+
+  Reader reader = {file.begin(), file.end(), false};
+  if (reader.get<uint32_t>() != MAGIC || reader.get<uint32_t>() != VERSION) {
+    return nullptr;
+  }
+
+  uint64_t hash = reader.get<uint64_t>();
+  if (reader.failed || fnv1a(reader.current, reader.end) != hash) {
+    return nullptr;
+  }
+
+  for (uint32_t sources = reader.getCount(12); sources > 0; sources--) {
+    std::string source(reader.getString());
+    uint64_t sourceHash = reader.get<uint64_t>();
+
+    uint64_t currentHash;
+    if (reader.failed || !hashFile(source.c_str(), currentHash) ||
+        currentHash != sourceHash) {
+      return nullptr;
+    }
+  }
+
+  std::vector<Symbol> globals;
+  for (uint32_t count = reader.getCount(4); count > 0; count--) {
+    globals.push_back(Symbol::intern(reader.getString()));
+  }
+
+  std::vector<const char *> files;
+  for (uint32_t count = reader.getCount(4); count > 0; count--) {
+    std::string filename(reader.getString());
+    files.push_back(SourceFiles::name(SourceFiles::intern(filename.c_str())));
+  }
+
+  std::shared_ptr<FnPrototype> program = readPrototype(reader, files);
+  if (!program || reader.current != reader.end) {
+    return nullptr;
+  }
+
+  // The code refers to globals by slot, they have to end up where they were
+  // when it was compiled.
+  for (size_t slot = 0; slot < globals.size(); slot++) {
+    if (vm.globalSlot(globals[slot]) != slot) {
+      return nullptr;
+    }
+  }
+
+  return program;
+}
+
+void store(const char *script, const std::vector<const char *> &files,
+           const FnPrototype &program, const VM &vm) {
+  Writer code;
+  if (!writePrototype(code, program)) {
+    return;
+  }
+
+  Writer body;
+  body.put<uint32_t>(files.size());
+  for (const char *file : files) {
+    uint64_t hash;
+    if (!hashFile(file, hash)) {
+      return;
+    }
+
+    body.putString(file);
+    body.put(hash);
+  }
+
+  body.put<uint32_t>(vm.getGlobals().size());
+  for (auto &&global : vm.getGlobals()) {
+    body.putString(global.name.str());
+  }
+
+  body.put<uint32_t>(code.locationFiles.size());
+  for (const char *filename : code.locationFiles) {
+    body.putString(filename);
+  }
+  body.out += code.out;
+
+  Writer header;
+  header.put(MAGIC);
+  header.put(VERSION);
+  header.put(fnv1a(body.out.data(), body.out.data() + body.out.size()));
+
+  // Written aside and renamed, another run never sees half a file.
+  std::string target = path(script), temporary = target + ".tmp";
+  std::ofstream stream(temporary, std::ios::binary);
+  stream << header.out << body.out;
+  stream.close();
+
+  if (stream) {
+    std::rename(temporary.c_str(), target.c_str());
+  } else {
+    std::remove(temporary.c_str());
+  }
+}
+} // namespace ModuleCache
@@ -0,0 +1,32 @@
+#ifndef MODULE_CACHE_H
+#define MODULE_CACHE_H
+
+#include "chunk.hpp"
+#include "vm.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compiled programs, saved next to their script as `<script>c`. A cache file
+// holds the bytecode of the script and of everything it imports, along with
+// a hash of each of these files. It's only used as long as none of them
+// changed, and is thrown away when it was written by another version of the
+// format.
+namespace ModuleCache {
+// Bumped whenever the bytecode or the layout of cache files changes.
+inline constexpr uint32_t VERSION = 5;
+
+std::string path(const char *script);
+
+// The program cached for `script`, or nullptr when there's no usable cache.
+// Registers the globals the program uses with `vm`.
+std::shared_ptr<FnPrototype> load(const char *script, VM &vm);
+
+// Saves `program`, compiled from `files` by `vm`, as the cache of `script`.
+// Failing to write it isn't an error, the script just won't be cached.
+void store(const char *script, const std::vector<const char *> &files,
+           const FnPrototype &program, const VM &vm);
+} // namespace ModuleCache
+
+#endif
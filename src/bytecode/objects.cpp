@@ -0,0 +1,26 @@
+#include "objects.hpp"
+#include "../interpretation/heap.hpp"
+#include "vm.hpp"
+
+LBPLCallable *LBPLClosure::bind(LBPLInstance *instance) {
+  return heap.allocate<LBPLBoundMethod>(instance, this);
+}
+
+Value LBPLClosure::call(Interpreter *, std::vector<Value> &args) {
+  return vm->call(this, this, args);
+}
+
+Value LBPLBoundMethod::call(Interpreter *, std::vector<Value> &args) {
+  return method->vm->call(receiver, method, args);
+}
+
+void LBPLClosure::trace(Heap &heap) {
+  for (auto &&upvalue : upvalues) {
+    heap.markObject(upvalue);
+  }
+}
+
+void LBPLBoundMethod::trace(Heap &heap) {
+  heap.markObject(receiver);
+  heap.markObject(method);
+}
@@ -0,0 +1,47 @@
+#ifndef BYTECODE_OBJECTS_H
+#define BYTECODE_OBJECTS_H
+
+#include "../interpretation/types/LBPLCallable.hpp"
+#include "../interpretation/types/LBPLInstance.hpp"
+#include "../interpretation/types/LBPLUpvalue.hpp"
+#include "chunk.hpp"
+
+#include <memory>
+#include <vector>
+
+class VM;
+
+class LBPLClosure : public LBPLCallable {
+public:
+  std::shared_ptr<FnPrototype> proto;
+  std::vector<LBPLUpvalue *> upvalues;
+  VM *vm;
+
+public:
+  LBPLClosure(std::shared_ptr<FnPrototype> &proto, VM *vm)
+      : LBPLCallable(CallableType::Closure), proto(proto),
+        upvalues(proto->upvalueCount), vm(vm) {}
+
+  LBPLCallable *bind(LBPLInstance *instance) override;
+
+  int arity() override { return proto->arity; }
+  Value call(Interpreter *, std::vector<Value> &) override;
+  void trace(Heap &) override;
+};
+
+class LBPLBoundMethod : public LBPLCallable {
+public:
+  LBPLInstance *receiver;
+  LBPLClosure *method;
+
+public:
+  LBPLBoundMethod(LBPLInstance *receiver, LBPLClosure *method)
+      : LBPLCallable(CallableType::BoundMethod), receiver(receiver),
+        method(method) {}
+
+  int arity() override { return method->arity(); }
+  Value call(Interpreter *, std::vector<Value> &) override;
+  void trace(Heap &) override;
+};
+
+#endif
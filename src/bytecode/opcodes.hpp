@@ -0,0 +1,73 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <cstdint>
+
+// Operands are stored inline after the opcode. `u8`/`u16` mark the size of
+// each operand, 16-bit operands are big endian.
+enum class OpCode : uint8_t {
+  Constant,     // u16 constant index
+  Nil,
+  True,
+  False,
+  Pop,
+
+  GetLocal,     // u8 slot
+  SetLocal,     // u8 slot
+  GetGlobal,    // u16 global slot
+  DefineGlobal, // u16 global slot
+  SetGlobal,    // u16 global slot
+  GetUpvalue,   // u8 upvalue index
+  SetUpvalue,   // u8 upvalue index
+  GetField,     // u16 name index, u16 inline cache index
+  SetField,     // u16 name index, u16 inline cache index
+  GetSuper,     // u16 name index
+
+  Equal,
+  NotEqual,
+  Greater,
+  GreaterEqual,
+  Less,
+  LessEqual,
+  Add,
+  Subtract,
+  Multiply,
+  Divide,
+  Modulo,
+  Not,
+  Negate,
+
+  Jump,         // u16 forward offset
+  JumpIfFalse,  // u16 forward offset, leaves the condition on the stack
+  Loop,         // u16 backward offset
+
+  Call,         // u8 argument count
+  TailCall,     // u8 argument count, result is returned by the caller
+  Invoke,       // u16 name index, u16 inline cache index, u8 argument count
+  TailInvoke,   // Invoke whose result is returned by the caller
+  Closure,      // u16 prototype index, then (u8 isLocal, u8 index) pairs
+  CloseUpvalue,
+  Return,
+
+  Class,        // u16 name index
+  Inherit,
+  Method,       // u16 name index
+
+  // Never emitted by the compiler. The VM rewrites instructions into these
+  // once it has seen their operands, and back when a guard fails. Fused
+  // instructions keep the bytes of the ones they replace and skip them.
+  AddNumbers,
+  SubtractNumbers,
+  MultiplyNumbers,
+  LessNumbers,
+  LessEqualNumbers,
+  GreaterNumbers,
+  GreaterEqualNumbers,
+  AddConstant,      // Constant then Add, a number constant
+  SubtractConstant, // Constant then Subtract, a number constant
+  LessConstant,     // Constant then Less, a number constant
+  AddLocal,         // GetLocal then Add
+  GetFieldCached,   // GetField whose cache only saw one shape, with a field
+};
+
+#endif
@@ -0,0 +1,806 @@
+#include "vm.hpp"
+#include "../interpretation/builtin_methods.hpp"
+#include "../interpretation/heap.hpp"
+#include "../interpretation/lazy_functions.hpp"
+#include "../interpretation/operations.hpp"
+#include "compiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+// Labels as values are a GNU extension, other compilers, or a build with
+// LBPL_SWITCH_DISPATCH defined, dispatch with a plain switch.
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    !defined(LBPL_SWITCH_DISPATCH)
+#define LBPL_COMPUTED_GOTO 1
+#else
+#define LBPL_COMPUTED_GOTO 0
+#endif
+
+VM::VM()
+    : frames(), stack(new Value[STACK_MAX]), stackTop(stack.get()),
+      openUpvalues(nullptr), script(nullptr), globals(), globalSlots() {
+  frames.reserve(FRAMES_MAX);
+
+  defineNative(Symbol::intern("println"), heap.allocate<LBPLPrintln>());
+  defineNative(Symbol::intern("clock"), heap.allocate<LBPLClock>());
+  defineNative(Symbol::intern("gcStats"), heap.allocate<LBPLGCStats>());
+  defineNative(Symbol::intern("StringBuilder"),
+               heap.allocate<LBPLNewStringBuilder>());
+  defineNative(Symbol::intern("append"), heap.allocate<LBPLAppend>());
+  defineNative(Symbol::intern("toString"), heap.allocate<LBPLToString>());
+  heap.addRoots(this);
+}
+
+VM::~VM() { heap.removeRoots(this); }
+
+void VM::markPrototype(Heap &heap, FnPrototype *proto) {
+  for (auto &&constant : proto->chunk.constants) {
+    heap.markValue(constant);
+  }
+  for (auto &&function : proto->chunk.functions) {
+    markPrototype(heap, function.get());
+  }
+}
+
+void VM::markRoots(Heap &heap) {
+  for (Value *slot = stack.get(); slot < stackTop; slot++) {
+    heap.markValue(*slot);
+  }
+  for (auto &&frame : frames) {
+    heap.markObject(frame.closure);
+  }
+  for (LBPLUpvalue *upvalue = openUpvalues; upvalue; upvalue = upvalue->next) {
+    heap.markObject(upvalue);
+  }
+  for (auto &&global : globals) {
+    heap.markValue(global.value);
+  }
+
+  if (script) {
+    markPrototype(heap, script.get());
+  }
+}
+
+void VM::addCacheSites(std::vector<CacheSite> &sites, FnPrototype *proto) {
+  Chunk &chunk = proto->chunk;
+
+  for (size_t i = 0; i < chunk.caches.size(); i++) {
+    size_t offset = chunk.cacheOffsets[i];
+    auto op = static_cast<OpCode>(chunk.code[offset]);
+    uint16_t name = (chunk.code[offset + 1] << 8) | chunk.code[offset + 2];
+
+    bool get = op == OpCode::GetField || op == OpCode::GetFieldCached;
+    sites.push_back({get                      ? "get"
+                     : op == OpCode::SetField ? "set"
+                                              : "invoke",
+                     chunk.names[name].str(), chunk.locations[offset],
+                     &chunk.caches[i]});
+  }
+  for (auto &&function : chunk.functions) {
+    addCacheSites(sites, function.get());
+  }
+}
+
+std::vector<CacheSite> VM::getCacheSites() {
+  std::vector<CacheSite> sites;
+  if (script) {
+    addCacheSites(sites, script.get());
+  }
+
+  return sites;
+}
+
+uint16_t VM::globalSlot(Symbol name) {
+  if (auto it = globalSlots.find(name); it != globalSlots.end()) {
+    return it->second;
+  }
+
+  globals.push_back({name, nullptr, false});
+  globalSlots.insert(std::make_pair(name, globals.size() - 1));
+  return globals.size() - 1;
+}
+
+void VM::defineNative(Symbol name, LBPLCallable *native) {
+  Global &global = globals[globalSlot(name)];
+  global.value = native;
+  global.defined = true;
+}
+
+void VM::resetStack() {
+  stackTop = stack.get();
+  frames.clear();
+  openUpvalues = nullptr;
+}
+
+void VM::interpret(std::shared_ptr<FnPrototype> &script) {
+  this->script = script;
+  auto closure = heap.allocate<LBPLClosure>(script, this);
+  push(closure);
+
+  try {
+    callClosure(closure, 0, {0, 0, ""});
+    run(0);
+  } catch (RuntimeError &e) {
+    std::cout << e.what();
+  }
+
+  resetStack();
+}
+
+Value VM::call(const Value &receiver, LBPLClosure *closure,
+               std::vector<Value> &args) {
+  size_t baseFrame = frames.size();
+
+  // It only has a first location to report errors at once compiled.
+  if (closure->proto->deferred) {
+    compileDeferred(closure->proto);
+  }
+  const SourceLocation &where = closure->proto->chunk.locations.front();
+  if (!hasRoom(stackTop, closure->proto.get())) {
+    throw RuntimeError(where, "Stack overflow.");
+  }
+
+  push(receiver);
+  for (auto &&arg : args) {
+    push(arg);
+  }
+
+  callClosure(closure, args.size(), where);
+  return run(baseFrame);
+}
+
+bool VM::callClosure(LBPLClosure *closure, int argc,
+                     const SourceLocation &where) {
+  if (argc != closure->proto->arity) {
+    throw RuntimeError(where, "Wrong number of arguments.");
+  }
+
+  if (closure->proto->deferred) {
+    compileDeferred(closure->proto);
+  }
+
+  Value *slots = stackTop - argc - 1;
+  if (frames.size() == FRAMES_MAX || !hasRoom(slots, closure->proto.get())) {
+    throw RuntimeError(where, "Stack overflow.");
+  }
+
+  frames.push_back({closure, closure->proto->chunk.code.data(), slots});
+  return true;
+}
+
+bool VM::tailCallValue(int argc, const SourceLocation &where) {
+  Value &callee = peek(argc);
+  if (callee.isCallable()) {
+    auto fn = callee.as<LBPLCallable>();
+    if (fn->type == CallableType::Closure) {
+      tailCallClosure(static_cast<LBPLClosure *>(fn), argc, where);
+      return true;
+    } else if (fn->type == CallableType::BoundMethod) {
+      auto bound = static_cast<LBPLBoundMethod *>(fn);
+      callee = bound->receiver;
+      tailCallClosure(bound->method, argc, where);
+      return true;
+    }
+  }
+
+  // Natives and class initializers get a frame of their own, the Return that
+  // follows hands their result back.
+  return callValue(argc, where);
+}
+
+void VM::tailCallClosure(LBPLClosure *closure, int argc,
+                         const SourceLocation &where) {
+  if (argc != closure->proto->arity) {
+    throw RuntimeError(where, "Wrong number of arguments.");
+  }
+  if (closure->proto->deferred) {
+    compileDeferred(closure->proto);
+  }
+
+  CallFrame &frame = frames.back();
+  if (!hasRoom(frame.slots, closure->proto.get())) {
+    throw RuntimeError(where, "Stack overflow.");
+  }
+
+  // Slide the callee and its arguments over the current frame.
+  closeUpvalues(frame.slots);
+  std::copy(stackTop - argc - 1, stackTop, frame.slots);
+  stackTop = frame.slots + argc + 1;
+  frame.closure = closure;
+  frame.ip = closure->proto->chunk.code.data();
+}
+
+// Top-level functions the parser skimmed are compiled when first called, the
+// globals their body names get a slot then.
+void VM::compileDeferred(const std::shared_ptr<FnPrototype> &proto) {
+  SourcePosition position = *proto->deferred;
+  FnStmt *stmt = LazyFunctions::parse(position);
+
+  Compiler compiler(*this);
+  compiler.compileDeferred(stmt, proto);
+  if (compiler.hadError) {
+    throw RuntimeError(SourceLocation{position.line, position.column,
+                                      SourceFiles::name(position.file)},
+                       "The function called has errors in its body.");
+  }
+
+  proto->deferred.reset();
+}
+
+bool VM::callValue(int argc, const SourceLocation &where) {
+  Value &callee = peek(argc);
+
+  if (callee.isCallable()) {
+    auto fn = callee.as<LBPLCallable>();
+    switch (fn->type) {
+    case CallableType::Closure:
+      return callClosure(static_cast<LBPLClosure *>(fn), argc, where);
+    case CallableType::BoundMethod: {
+      auto bound = static_cast<LBPLBoundMethod *>(fn);
+      callee = bound->receiver;
+      return callClosure(bound->method, argc, where);
+    }
+    default: {
+      if (fn->arity() != argc) {
+        throw RuntimeError(where, "Wrong number of arguments.");
+      }
+
+      std::vector<Value> args(stackTop - argc, stackTop);
+      Value result = fn->call(nullptr, args);
+      stackTop -= argc + 1;
+      push(result);
+      return false;
+    }
+    }
+  } else if (callee.isClass()) {
+    auto klass = callee.as<LBPLClass>();
+    callee = heap.allocate<LBPLInstance>(klass);
+
+    if (auto init = klass->findMethod(Symbol::initName)) {
+      return callClosure(static_cast<LBPLClosure *>(init), argc, where);
+    } else if (argc != 0) {
+      throw RuntimeError(where, "Wrong number of arguments.");
+    }
+
+    return false;
+  }
+
+  throw RuntimeError(where, "Can only call a function or class initializer.");
+}
+
+LBPLUpvalue *VM::captureUpvalue(Value *local) {
+  LBPLUpvalue *prev = nullptr;
+  LBPLUpvalue *upvalue = openUpvalues;
+
+  while (upvalue && upvalue->location > local) {
+    prev = upvalue;
+    upvalue = upvalue->next;
+  }
+
+  if (upvalue && upvalue->location == local) {
+    return upvalue;
+  }
+
+  auto created = heap.allocate<LBPLUpvalue>(local);
+  created->next = upvalue;
+
+  if (prev) {
+    prev->next = created;
+  } else {
+    openUpvalues = created;
+  }
+
+  return created;
+}
+
+void VM::closeUpvalues(Value *last) {
+  while (openUpvalues && openUpvalues->location >= last) {
+    openUpvalues->closed = *openUpvalues->location;
+    openUpvalues->location = &openUpvalues->closed;
+    openUpvalues = openUpvalues->next;
+  }
+}
+
+Value VM::run(size_t baseFrame) {
+  CallFrame *frame = &frames.back();
+  const uint8_t *ip = frame->ip;
+  const uint8_t *start = ip;
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, static_cast<uint16_t>((ip[-2] << 8) | ip[-1]))
+#define CHUNK() (frame->closure->proto->chunk)
+#define LOCATION() (CHUNK().locations[start - CHUNK().code.data()])
+#define BINARY_OP(tokenType)                                                   \
+  do {                                                                         \
+    Value right = pop();                                                       \
+    Value left = pop();                                                        \
+    push(performBinaryOperation(tokenType, left, right, LOCATION()));          \
+  } while (0)
+// Every live value is on the stack between two instructions, backward jumps
+// and calls are where collections happen so that no loop can outrun them.
+#define SAFEPOINT()                                                            \
+  do {                                                                         \
+    if (heap.shouldCollect()) {                                                \
+      heap.collect();                                                          \
+    }                                                                          \
+  } while (0)
+#define RELOAD_FRAME()                                                         \
+  do {                                                                         \
+    frame = &frames.back();                                                    \
+    ip = frame->ip;                                                            \
+  } while (0)
+// Each handler ends by dispatching the next instruction itself. With
+// computed gotos the switch is only entered for the first one, every handler
+// then jumps straight to the next, so the branch predictor sees one indirect
+// jump per opcode instead of a single shared one.
+#if LBPL_COMPUTED_GOTO
+#define TARGET(op)                                                             \
+  case OpCode::op:                                                             \
+  target_##op
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    start = ip;                                                                \
+    goto *dispatchTable[READ_BYTE()];                                          \
+  } while (0)
+
+  // In the order of `OpCode`.
+  static void *const dispatchTable[] = {
+      &&target_Constant,     &&target_Nil,          &&target_True,
+      &&target_False,        &&target_Pop,          &&target_GetLocal,
+      &&target_SetLocal,     &&target_GetGlobal,    &&target_DefineGlobal,
+      &&target_SetGlobal,    &&target_GetUpvalue,   &&target_SetUpvalue,
+      &&target_GetField,     &&target_SetField,     &&target_GetSuper,
+      &&target_Equal,        &&target_NotEqual,     &&target_Greater,
+      &&target_GreaterEqual, &&target_Less,         &&target_LessEqual,
+      &&target_Add,          &&target_Subtract,     &&target_Multiply,
+      &&target_Divide,       &&target_Modulo,       &&target_Not,
+      &&target_Negate,       &&target_Jump,         &&target_JumpIfFalse,
+      &&target_Loop,         &&target_Call,         &&target_TailCall,
+      &&target_Invoke,       &&target_TailInvoke,   &&target_Closure,
+      &&target_CloseUpvalue, &&target_Return,       &&target_Class,
+      &&target_Inherit,      &&target_Method,       &&target_AddNumbers,
+      &&target_SubtractNumbers,     &&target_MultiplyNumbers,
+      &&target_LessNumbers,         &&target_LessEqualNumbers,
+      &&target_GreaterNumbers,      &&target_GreaterEqualNumbers,
+      &&target_AddConstant,         &&target_SubtractConstant,
+      &&target_LessConstant,        &&target_AddLocal,
+      &&target_GetFieldCached,
+  };
+  static_assert(std::size(dispatchTable) ==
+                static_cast<size_t>(OpCode::GetFieldCached) + 1);
+#else
+#define TARGET(op) case OpCode::op
+#define DISPATCH() continue
+#endif
+// The next time it runs, the instruction being run is `op`.
+#define QUICKEN(op)                                                            \
+  (CHUNK().code[start - CHUNK().code.data()] = static_cast<uint8_t>(op))
+// Turns the instruction back into the generic `op` and runs that instead.
+#define DEOPTIMIZE(op)                                                         \
+  {                                                                            \
+    QUICKEN(op);                                                               \
+    ip = start;                                                                \
+    DISPATCH();                                                                \
+  }
+// Generic binary operations get quickened once they see two numbers.
+#define QUICKENING_BINARY_OP(tokenType, quickened)                             \
+  {                                                                            \
+    if (peek(0).isDouble() && peek(1).isDouble()) {                            \
+      QUICKEN(quickened);                                                      \
+    }                                                                          \
+    BINARY_OP(tokenType);                                                      \
+  }
+#define NUMBER_OP(op, generic)                                                 \
+  {                                                                            \
+    if (!peek(0).isDouble() || !peek(1).isDouble()) {                          \
+      DEOPTIMIZE(generic);                                                     \
+    }                                                                          \
+    double right = pop().asDouble();                                           \
+    peek(0) = Value(peek(0).asDouble() op right);                              \
+  }
+
+  try {
+    while (1) {
+      start = ip;
+
+      switch (static_cast<OpCode>(READ_BYTE())) {
+      TARGET(Constant): {
+        const Value &constant = CHUNK().constants[READ_SHORT()];
+
+        // A number the value below is added to, subtracted from or compared
+        // with.
+        if (constant.isDouble() && peek(0).isDouble()) {
+          switch (static_cast<OpCode>(*ip)) {
+          case OpCode::Add:
+          case OpCode::AddNumbers:
+            QUICKEN(OpCode::AddConstant);
+            break;
+          case OpCode::Subtract:
+          case OpCode::SubtractNumbers:
+            QUICKEN(OpCode::SubtractConstant);
+            break;
+          case OpCode::Less:
+          case OpCode::LessNumbers:
+            QUICKEN(OpCode::LessConstant);
+            break;
+          default:
+            break;
+          }
+        }
+
+        push(constant);
+      } DISPATCH();
+      TARGET(Nil):
+        push(nullptr);
+        DISPATCH();
+      TARGET(True):
+        push(true);
+        DISPATCH();
+      TARGET(False):
+        push(false);
+        DISPATCH();
+      TARGET(Pop):
+        --stackTop;
+        DISPATCH();
+
+      TARGET(GetLocal): {
+        const Value &local = frame->slots[READ_BYTE()];
+        OpCode next = static_cast<OpCode>(*ip);
+        if ((next == OpCode::Add || next == OpCode::AddNumbers) &&
+            local.isDouble() && peek(0).isDouble()) {
+          QUICKEN(OpCode::AddLocal);
+        }
+
+        push(local);
+      } DISPATCH();
+      TARGET(SetLocal):
+        frame->slots[READ_BYTE()] = peek(0);
+        DISPATCH();
+      TARGET(GetGlobal): {
+        Global &global = globals[READ_SHORT()];
+        if (!global.defined) {
+          throw RuntimeError(LOCATION(),
+                             "Undefined name '" + global.name.str() + "'.");
+        }
+
+        push(global.value);
+      } DISPATCH();
+      TARGET(DefineGlobal): {
+        Global &global = globals[READ_SHORT()];
+        global.value = pop();
+        global.defined = true;
+      } DISPATCH();
+      TARGET(SetGlobal): {
+        Global &global = globals[READ_SHORT()];
+        if (!global.defined) {
+          throw RuntimeError(LOCATION(),
+                             "Undefined variable '" + global.name.str() + "'.");
+        }
+
+        global.value = peek(0);
+      } DISPATCH();
+      TARGET(GetUpvalue):
+        push(*frame->closure->upvalues[READ_BYTE()]->location);
+        DISPATCH();
+      TARGET(SetUpvalue):
+        *frame->closure->upvalues[READ_BYTE()]->location = peek(0);
+        DISPATCH();
+
+      TARGET(GetField): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        InlineCache &cache = CHUNK().caches[READ_SHORT()];
+        if (!peek(0).isInstance()) {
+          throw RuntimeError(LOCATION(),
+                             "Only instances of classes can have properties");
+        }
+
+        auto instance = peek(0).as<LBPLInstance>();
+        auto entry = instance->lookup(name, cache);
+        if (entry.slot >= 0) {
+          peek(0) = instance->fields[entry.slot];
+          if (cache.count == 1) {
+            QUICKEN(OpCode::GetFieldCached);
+          }
+        } else if (entry.method) {
+          peek(0) = entry.method->bind(instance);
+        } else {
+          throw RuntimeError(LOCATION(),
+                             "Undefined field '" + name.str() + "'.");
+        }
+      } DISPATCH();
+      TARGET(SetField): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        InlineCache &cache = CHUNK().caches[READ_SHORT()];
+        if (!peek(1).isInstance()) {
+          throw RuntimeError(LOCATION(),
+                             "Only instances of classes can have properties");
+        }
+
+        peek(1).as<LBPLInstance>()->store(name, pop(), cache);
+        peek(0) = nullptr;
+      } DISPATCH();
+      TARGET(GetSuper): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        auto superclass = pop().as<LBPLClass>();
+        auto instance = peek(0).as<LBPLInstance>();
+
+        if (auto method = superclass->findMethod(name)) {
+          peek(0) = method->bind(instance);
+        } else {
+          throw RuntimeError(LOCATION(),
+                             "Undefined field '" + name.str() + "'.");
+        }
+      } DISPATCH();
+
+      TARGET(Equal):
+        BINARY_OP(TokenType::EqualEqual);
+        DISPATCH();
+      TARGET(NotEqual):
+        BINARY_OP(TokenType::BangEqual);
+        DISPATCH();
+      TARGET(Greater):
+        QUICKENING_BINARY_OP(TokenType::Greater, OpCode::GreaterNumbers);
+        DISPATCH();
+      TARGET(GreaterEqual):
+        QUICKENING_BINARY_OP(TokenType::GreaterEqual,
+                             OpCode::GreaterEqualNumbers);
+        DISPATCH();
+      TARGET(Less):
+        QUICKENING_BINARY_OP(TokenType::Less, OpCode::LessNumbers);
+        DISPATCH();
+      TARGET(LessEqual):
+        QUICKENING_BINARY_OP(TokenType::LessEqual, OpCode::LessEqualNumbers);
+        DISPATCH();
+      TARGET(Add):
+        QUICKENING_BINARY_OP(TokenType::Plus, OpCode::AddNumbers);
+        DISPATCH();
+      TARGET(Subtract):
+        QUICKENING_BINARY_OP(TokenType::Minus, OpCode::SubtractNumbers);
+        DISPATCH();
+      TARGET(Multiply):
+        QUICKENING_BINARY_OP(TokenType::Star, OpCode::MultiplyNumbers);
+        DISPATCH();
+      TARGET(Divide):
+        BINARY_OP(TokenType::Slash);
+        DISPATCH();
+      TARGET(Modulo):
+        BINARY_OP(TokenType::ModOp);
+        DISPATCH();
+      TARGET(Not):
+        peek(0) = performUnaryOperation(TokenType::Bang, peek(0));
+        DISPATCH();
+      TARGET(Negate):
+        peek(0) = performUnaryOperation(TokenType::Minus, peek(0));
+        DISPATCH();
+
+      TARGET(Jump): {
+        uint16_t offset = READ_SHORT();
+        ip += offset;
+      } DISPATCH();
+      TARGET(JumpIfFalse): {
+        uint16_t offset = READ_SHORT();
+        if (!isTruthy(peek(0))) {
+          ip += offset;
+        }
+      } DISPATCH();
+      TARGET(Loop): {
+        uint16_t offset = READ_SHORT();
+        ip -= offset;
+        SAFEPOINT();
+      } DISPATCH();
+
+      TARGET(Call): {
+        int argc = READ_BYTE();
+        frame->ip = ip;
+        SAFEPOINT();
+        if (callValue(argc, LOCATION())) {
+          RELOAD_FRAME();
+        }
+      } DISPATCH();
+      TARGET(TailCall): {
+        int argc = READ_BYTE();
+        frame->ip = ip;
+        SAFEPOINT();
+        if (tailCallValue(argc, LOCATION())) {
+          RELOAD_FRAME();
+        }
+      } DISPATCH();
+      TARGET(Invoke): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        InlineCache &cache = CHUNK().caches[READ_SHORT()];
+        int argc = READ_BYTE();
+        frame->ip = ip;
+        SAFEPOINT();
+
+        if (!peek(argc).isInstance()) {
+          throw RuntimeError(LOCATION(),
+                             "Only instances of classes can have properties");
+        }
+
+        auto instance = peek(argc).as<LBPLInstance>();
+        auto entry = instance->lookup(name, cache);
+        if (entry.slot >= 0) {
+          peek(argc) = instance->fields[entry.slot];
+          if (callValue(argc, LOCATION())) {
+            RELOAD_FRAME();
+          }
+        } else if (entry.method) {
+          callClosure(static_cast<LBPLClosure *>(entry.method), argc,
+                      LOCATION());
+          RELOAD_FRAME();
+        } else {
+          throw RuntimeError(LOCATION(),
+                             "Undefined field '" + name.str() + "'.");
+        }
+      } DISPATCH();
+      TARGET(TailInvoke): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        InlineCache &cache = CHUNK().caches[READ_SHORT()];
+        int argc = READ_BYTE();
+        frame->ip = ip;
+        SAFEPOINT();
+
+        if (!peek(argc).isInstance()) {
+          throw RuntimeError(LOCATION(),
+                             "Only instances of classes can have properties");
+        }
+
+        auto instance = peek(argc).as<LBPLInstance>();
+        auto entry = instance->lookup(name, cache);
+        if (entry.slot >= 0) {
+          peek(argc) = instance->fields[entry.slot];
+          if (tailCallValue(argc, LOCATION())) {
+            RELOAD_FRAME();
+          }
+        } else if (entry.method) {
+          tailCallClosure(static_cast<LBPLClosure *>(entry.method), argc,
+                          LOCATION());
+          RELOAD_FRAME();
+        } else {
+          throw RuntimeError(LOCATION(),
+                             "Undefined field '" + name.str() + "'.");
+        }
+      } DISPATCH();
+      TARGET(Closure): {
+        auto &proto = CHUNK().functions[READ_SHORT()];
+        auto closure = heap.allocate<LBPLClosure>(proto, this);
+
+        for (auto &&upvalue : closure->upvalues) {
+          uint8_t isLocal = READ_BYTE();
+          uint8_t index = READ_BYTE();
+
+          upvalue = isLocal ? captureUpvalue(frame->slots + index)
+                            : frame->closure->upvalues[index];
+        }
+
+        push(closure);
+      } DISPATCH();
+      TARGET(CloseUpvalue):
+        closeUpvalues(stackTop - 1);
+        --stackTop;
+        DISPATCH();
+      TARGET(Return): {
+        Value result = pop();
+        closeUpvalues(frame->slots);
+        stackTop = frame->slots;
+        frames.pop_back();
+
+        if (frames.size() == baseFrame) {
+          return result;
+        }
+
+        push(result);
+        RELOAD_FRAME();
+      } DISPATCH();
+
+      TARGET(Class): {
+        std::unordered_map<Symbol, LBPLCallable *> methods;
+        push(heap.allocate<LBPLClass>(CHUNK().names[READ_SHORT()].str(),
+                                      methods));
+      } DISPATCH();
+      TARGET(Inherit): {
+        if (!peek(1).isClass()) {
+          throw RuntimeError(LOCATION(), "Superclass must be another class.");
+        }
+
+        peek(0).as<LBPLClass>()->superclass = peek(1).as<LBPLClass>();
+        --stackTop;
+      } DISPATCH();
+      TARGET(Method): {
+        Symbol name = CHUNK().names[READ_SHORT()];
+        auto klass = peek(1).as<LBPLClass>();
+        klass->methods.insert_or_assign(name, pop().as<LBPLCallable>());
+      } DISPATCH();
+
+      TARGET(AddNumbers):
+        NUMBER_OP(+, OpCode::Add);
+        DISPATCH();
+      TARGET(SubtractNumbers):
+        NUMBER_OP(-, OpCode::Subtract);
+        DISPATCH();
+      TARGET(MultiplyNumbers):
+        NUMBER_OP(*, OpCode::Multiply);
+        DISPATCH();
+      TARGET(LessNumbers):
+        NUMBER_OP(<, OpCode::Less);
+        DISPATCH();
+      TARGET(LessEqualNumbers):
+        NUMBER_OP(<=, OpCode::LessEqual);
+        DISPATCH();
+      TARGET(GreaterNumbers):
+        NUMBER_OP(>, OpCode::Greater);
+        DISPATCH();
+      TARGET(GreaterEqualNumbers):
+        NUMBER_OP(>=, OpCode::GreaterEqual);
+        DISPATCH();
+      TARGET(AddConstant): {
+        double constant = CHUNK().constants[READ_SHORT()].asDouble();
+        if (!peek(0).isDouble()) {
+          DEOPTIMIZE(OpCode::Constant);
+        }
+
+        peek(0) = peek(0).asDouble() + constant;
+        ip++;
+      } DISPATCH();
+      TARGET(SubtractConstant): {
+        double constant = CHUNK().constants[READ_SHORT()].asDouble();
+        if (!peek(0).isDouble()) {
+          DEOPTIMIZE(OpCode::Constant);
+        }
+
+        peek(0) = peek(0).asDouble() - constant;
+        ip++;
+      } DISPATCH();
+      TARGET(LessConstant): {
+        double constant = CHUNK().constants[READ_SHORT()].asDouble();
+        if (!peek(0).isDouble()) {
+          DEOPTIMIZE(OpCode::Constant);
+        }
+
+        peek(0) = peek(0).asDouble() < constant;
+        ip++;
+      } DISPATCH();
+      TARGET(AddLocal): {
+        const Value &local = frame->slots[READ_BYTE()];
+        if (!local.isDouble() || !peek(0).isDouble()) {
+          DEOPTIMIZE(OpCode::GetLocal);
+        }
+
+        peek(0) = peek(0).asDouble() + local.asDouble();
+        ip++;
+      } DISPATCH();
+      TARGET(GetFieldCached): {
+        ip += 2;
+        InlineCache &cache = CHUNK().caches[READ_SHORT()];
+        const InlineCache::Entry &entry = cache.entries[0];
+        if (!peek(0).isInstance() ||
+            peek(0).as<LBPLInstance>()->shape->id != entry.shapeId) {
+          DEOPTIMIZE(OpCode::GetField);
+        }
+
+        cache.hits++;
+        peek(0) = peek(0).as<LBPLInstance>()->fields[entry.slot];
+      } DISPATCH();
+      }
+    }
+  } catch (RuntimeError &) {
+    frame->ip = ip;
+    throw;
+  }
+
+#undef READ_BYTE
+#undef READ_SHORT
+#undef CHUNK
+#undef LOCATION
+#undef BINARY_OP
+#undef SAFEPOINT
+#undef RELOAD_FRAME
+#undef TARGET
+#undef DISPATCH
+#undef QUICKEN
+#undef DEOPTIMIZE
+#undef QUICKENING_BINARY_OP
+#undef NUMBER_OP
+}
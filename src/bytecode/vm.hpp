@@ -0,0 +1,91 @@
+#ifndef VM_H
+#define VM_H
+
+#include "../interpretation/heap.hpp"
+#include "../interpretation/runtime_error.hpp"
+#include "../interpretation/types/LBPLClass.hpp"
+#include "../interpretation/types/LBPLInstance.hpp"
+#include "chunk.hpp"
+#include "objects.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Frames check that the stack has room for the most values they can hold
+// when they're called, 256 per frame is only the average.
+#define FRAMES_MAX 1024
+#define SLOTS_PER_FRAME 256
+#define STACK_MAX (FRAMES_MAX * SLOTS_PER_FRAME)
+
+class VM : public GCRoots {
+public:
+  struct Global {
+    Symbol name;
+    Value value;
+    bool defined;
+  };
+
+private:
+  struct CallFrame {
+    LBPLClosure *closure;
+    const uint8_t *ip;
+    Value *slots;
+  };
+
+  std::vector<CallFrame> frames;
+  std::unique_ptr<Value[]> stack;
+  Value *stackTop;
+  LBPLUpvalue *openUpvalues;
+  // Root of every prototype, and so of every constant, the VM can run.
+  std::shared_ptr<FnPrototype> script;
+
+  std::vector<Global> globals;
+  std::unordered_map<Symbol, uint16_t> globalSlots;
+
+private:
+  Value run(size_t baseFrame);
+
+  inline void push(Value value) { *stackTop++ = value; }
+  inline Value pop() { return *--stackTop; }
+  inline Value &peek(int distance) { return stackTop[-1 - distance]; }
+  // Whether a frame of `proto` starting at `slots` fits in the stack.
+  inline bool hasRoom(Value *slots, const FnPrototype *proto) {
+    return slots + proto->maxStack <= stack.get() + STACK_MAX;
+  }
+
+  bool callValue(int argc, const SourceLocation &);
+  bool callClosure(LBPLClosure *, int argc, const SourceLocation &);
+  // Like `callValue` and `callClosure`, but the callee replaces the running
+  // frame instead of getting one on top of it.
+  bool tailCallValue(int argc, const SourceLocation &);
+  void tailCallClosure(LBPLClosure *, int argc, const SourceLocation &);
+  void compileDeferred(const std::shared_ptr<FnPrototype> &);
+  LBPLUpvalue *captureUpvalue(Value *local);
+  void markPrototype(Heap &, FnPrototype *);
+  void addCacheSites(std::vector<CacheSite> &, FnPrototype *);
+  void closeUpvalues(Value *last);
+
+  void defineNative(Symbol, LBPLCallable *);
+  void resetStack();
+
+public:
+  VM();
+  ~VM();
+
+  uint16_t globalSlot(Symbol name);
+  inline const std::vector<Global> &getGlobals() const { return globals; }
+
+  void interpret(std::shared_ptr<FnPrototype> &script);
+  void markRoots(Heap &) override;
+  std::vector<CacheSite> getCacheSites();
+
+  // Runs `closure` to completion from native code, `receiver` becomes the
+  // callee slot of the new frame (`this` inside methods).
+  Value call(const Value &receiver, LBPLClosure *closure,
+             std::vector<Value> &args);
+};
+
+#endif
@@ -1,29 +1,32 @@
 #ifndef BUILTIN_METHODS_H
 #define BUILTIN_METHODS_H
 
+#include "heap.hpp"
+#include "operations.hpp"
 #include "types/LBPLCallable.hpp"
+#include "types/LBPLString.hpp"
 
 #include <chrono>
 #include <iostream>
-#include <variant>
+#include <sstream>
 
 class LBPLPrintln : public LBPLCallable {
 public:
-  LBPLPrintln() {}
+  LBPLPrintln() : LBPLCallable(CallableType::Native) {}
 
   constexpr int arity() override { return 1; };
 
   Value call(Interpreter *, std::vector<Value> &args) override {
-    if (std::holds_alternative<std::string>(args[0])) {
-      std::cout << std::get<std::string>(args[0]) << std::endl;
-    } else if (std::holds_alternative<int>(args[0])) {
-      std::cout << std::get<int>(args[0]) << std::endl;
-    } else if (std::holds_alternative<double>(args[0])) {
-      std::cout << std::get<double>(args[0]) << std::endl;
-    } else if (std::holds_alternative<char>(args[0])) {
-      std::cout << std::get<char>(args[0]) << std::endl;
-    } else if (std::holds_alternative<bool>(args[0])) {
-      std::cout << (std::get<bool>(args[0]) ? "true" : "false") << std::endl;
+    if (args[0].isString()) {
+      std::cout << args[0].as<LBPLString>()->str() << std::endl;
+    } else if (args[0].isInt()) {
+      std::cout << args[0].asInt() << std::endl;
+    } else if (args[0].isDouble()) {
+      std::cout << args[0].asDouble() << std::endl;
+    } else if (args[0].isChar()) {
+      std::cout << args[0].asChar() << std::endl;
+    } else if (args[0].isBool()) {
+      std::cout << (args[0].asBool() ? "true" : "false") << std::endl;
     }
 
     return nullptr;
@@ -32,11 +35,11 @@ public:
 
 class LBPLClock : public LBPLCallable {
 public:
-  LBPLClock() {}
+  LBPLClock() : LBPLCallable(CallableType::Native) {}
 
   constexpr int arity() override { return 0; };
 
-  Value call(Interpreter *, std::vector<Value> &args) override {
+  Value call(Interpreter *, std::vector<Value> &) override {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
                std::chrono::system_clock::now().time_since_epoch())
                .count() /
@@ -44,4 +47,83 @@ public:
   }
 };
 
+class LBPLGCStats : public LBPLCallable {
+public:
+  LBPLGCStats() : LBPLCallable(CallableType::Native) {}
+
+  constexpr int arity() override { return 0; };
+
+  Value call(Interpreter *, std::vector<Value> &) override {
+    Heap::Stats stats = heap.getStats();
+
+    std::stringstream ss;
+    ss << "collections: " << stats.collections
+       << ", pause: " << stats.totalPauseMs << "ms"
+       << " (max " << stats.maxPauseMs << "ms)"
+       << ", live: " << stats.liveBytes << " bytes"
+       << ", heap: " << stats.heapBytes << " bytes"
+       << ", freed: " << stats.freedBytes << " bytes";
+    return heap.allocate<LBPLString>(ss.str());
+  }
+};
+
+class LBPLNewStringBuilder : public LBPLCallable {
+public:
+  LBPLNewStringBuilder() : LBPLCallable(CallableType::Native) {}
+
+  constexpr int arity() override { return 0; };
+
+  Value call(Interpreter *, std::vector<Value> &) override {
+    return heap.allocate<LBPLStringBuilder>();
+  }
+};
+
+// Appends a string or a number, in the form `+` would concatenate it, to a
+// builder and returns the builder. Anything else returns nil.
+class LBPLAppend : public LBPLCallable {
+public:
+  LBPLAppend() : LBPLCallable(CallableType::Native) {}
+
+  constexpr int arity() override { return 2; };
+
+  Value call(Interpreter *, std::vector<Value> &args) override {
+    if (!args[0].isObjType(ObjType::StringBuilder)) {
+      return nullptr;
+    }
+
+    auto builder = args[0].as<LBPLStringBuilder>();
+    if (!appendText(builder->buffer, args[1])) {
+      return nullptr;
+    }
+
+    heap.resize(builder,
+                sizeof(LBPLStringBuilder) + builder->buffer.capacity());
+    return builder;
+  }
+};
+
+// The text of a builder, string or number as a string, nil for anything
+// else.
+class LBPLToString : public LBPLCallable {
+public:
+  LBPLToString() : LBPLCallable(CallableType::Native) {}
+
+  constexpr int arity() override { return 1; };
+
+  Value call(Interpreter *, std::vector<Value> &args) override {
+    if (args[0].isObjType(ObjType::StringBuilder)) {
+      return heap.allocate<LBPLString>(
+          args[0].as<LBPLStringBuilder>()->buffer);
+    } else if (args[0].isString()) {
+      return args[0];
+    }
+
+    std::string text;
+    if (!appendText(text, args[0])) {
+      return nullptr;
+    }
+    return heap.allocate<LBPLString>(std::move(text));
+  }
+};
+
 #endif
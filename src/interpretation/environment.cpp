@@ -1,95 +1,129 @@
 #include "environment.hpp"
+#include "heap.hpp"
 #include "types/LBPLTypes.hpp"
 #include "runtime_error.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <string>
 #include <utility>
 #include <variant>
 
-void Environment::define(const std::string &name, Value &value) {
+static void printValueType(const Value &value) {
+  if (value.isInt()) {
+    std::cout << "int" << std::endl;
+  } else if (value.isDouble()) {
+    std::cout << "double" << std::endl;
+  } else if (value.isChar()) {
+    std::cout << "char" << std::endl;
+  } else if (value.isNil()) {
+    std::cout << "nullptr" << std::endl;
+  } else if (value.isCallable()) {
+    std::cout << "callable" << std::endl;
+  } else if (value.isClass()) {
+    std::cout << "class" << std::endl;
+  } else if (value.isInstance()) {
+    std::cout << "instance" << std::endl;
+  } else {
+    std::cout << "idk" << std::endl;
+  }
+}
+
+void GlobalEnvironment::define(Symbol name, Value &value) {
   env.insert(std::make_pair(name, value));
 }
-void Environment::define(const std::string &name, Value &&value) {
+void GlobalEnvironment::define(Symbol name, Value &&value) {
   env.insert(std::make_pair(name, value));
 }
 
-Value Environment::get(std::shared_ptr<const Token> &name) {
-  const char *namestr = std::get<const char *>(name->lexeme);
-  auto it = env.find(namestr);
+Value GlobalEnvironment::get(const Token *name) {
+  auto it = env.find(name->symbol);
 
   if (it != env.end()) {
     return it->second;
   }
-  if (enclosing) {
-    return enclosing->get(name);
-  }
 
-  throw RuntimeError(name.get(),
-                     "Undefined name '" + std::string(namestr) + "'.");
+  throw RuntimeError(name, "Undefined name '" + name->symbol.str() + "'.");
 }
 
-Value Environment::getAt(int depth, std::shared_ptr<const Token> &name) {
-  return getAt(depth, std::get<const char *>(name->lexeme));
-}
+void GlobalEnvironment::assign(const Token *name, Value &value) {
+  auto it = env.find(name->symbol);
 
-Value Environment::getAt(int depth, const std::string &name) {
-  if (depth > 0) {
-    return enclosing->getAt(depth - 1, name);
+  if (it == env.end()) {
+    throw RuntimeError(name,
+                       "Undefined variable '" + name->symbol.str() + "'.");
   }
+  it->second = value;
+}
 
-  auto it = env.find(name);
-  return it != env.end() ? it->second : nullptr;
+void GlobalEnvironment::assign(const Token *name, Value &&value) {
+  assign(name, value);
 }
 
-void Environment::assign(std::shared_ptr<const Token> &name, Value &value) {
-  if (auto namestr = std::get<const char *>(name->lexeme);
-      env.contains(namestr)) {
-    env.insert_or_assign(namestr, value);
-  } else if (enclosing) {
-    enclosing->assign(name, value);
-  } else {
-    throw RuntimeError(name.get(),
-                       "Undefined variable '" + std::string(namestr) + "'.");
+void GlobalEnvironment::printEnv(const std::string &&msg) {
+  std::cout << "========" << msg << "=========" << std::endl;
+  for (const auto &[key, value] : env) {
+    std::cout << "\t" << key.str() << ": ";
+    printValueType(value);
   }
+  std::cout << "===================================" << std::endl;
 }
 
-void Environment::assign(std::shared_ptr<const Token> &name, Value &&value) {
-  assign(name, value);
+void Environment::trace(Heap &heap) {
+  for (size_t slot = 0; slot < slotCount; slot++) {
+    heap.markValue(values[slot]);
+  }
 }
 
-void Environment::assignAt(int depth, std::shared_ptr<const Token> &name,
-                           Value &value) {
-  if (depth > 0) {
-    enclosing->assignAt(depth - 1, name, value);
+void Environment::printEnv(const std::string &&msg) {
+  std::cout << "========" << msg << "=========" << std::endl;
+  for (size_t slot = 0; slot < slotCount; slot++) {
+    std::cout << "\t#" << slot << ": ";
+    printValueType(values[slot]);
   }
+  std::cout << "===================================" << std::endl;
+}
+
+Environment *EnvironmentArena::allocate(size_t slotCount,
+                                        Environment *enclosing) {
+  size_t bytes = bytesFor(slotCount);
+
+  if (chunks[current].used + bytes > chunks[current].capacity) {
+    current++;
+    // Chunks past the current one are free, a too small one is replaced.
+    if (current == chunks.size()) {
+      chunks.push_back({nullptr, 0, 0});
+    }
+    if (chunks[current].capacity < bytes) {
+      size_t capacity = std::max(CHUNK_SIZE, bytes);
+      chunks[current].memory = std::make_unique<std::byte[]>(capacity);
+      chunks[current].capacity = capacity;
+    }
+    chunks[current].used = 0;
+  }
+
+  std::byte *memory = chunks[current].memory.get() + chunks[current].used;
+  chunks[current].used += bytes;
 
-  env.insert_or_assign(std::get<const char *>(name->lexeme), value);
+  auto values = reinterpret_cast<Value *>(memory + sizeof(Environment));
+  return new (memory) Environment(values, slotCount, enclosing);
 }
 
-void Environment::printEnv(const std::string &&msg) {
-  std::cout << "========" << msg << "=========" << std::endl;
-  for (const auto &[key, value] : env) {
-    std::cout << "\t" << key << ": ";
-
-    if (std::holds_alternative<int>(value)) {
-      std::cout << "int" << std::endl;
-    } else if (std::holds_alternative<double>(value)) {
-      std::cout << "double" << std::endl;
-    } else if (std::holds_alternative<char>(value)) {
-      std::cout << "char" << std::endl;
-    } else if (std::holds_alternative<std::nullptr_t>(value)) {
-      std::cout << "nullptr" << std::endl;
-    } else if (std::holds_alternative<std::shared_ptr<LBPLCallable>>(value)) {
-      std::cout << "callable" << std::endl;
-    } else if (std::holds_alternative<std::shared_ptr<LBPLClass>>(value)) {
-      std::cout << "class" << std::endl;
-    } else if (std::holds_alternative<std::shared_ptr<LBPLInstance>>(value)) {
-      std::cout << "instance" << std::endl;
-    } else {
-      std::cout << "idk" << std::endl;
+void EnvironmentArena::release(Mark mark) {
+  current = mark.chunk;
+  chunks[current].used = mark.used;
+}
+
+void EnvironmentArena::trace(Heap &heap) {
+  for (size_t chunk = 0; chunk <= current; chunk++) {
+    std::byte *memory = chunks[chunk].memory.get();
+
+    for (size_t offset = 0; offset < chunks[chunk].used;) {
+      auto env = reinterpret_cast<Environment *>(memory + offset);
+      env->trace(heap);
+      offset += bytesFor(env->slotCount);
     }
   }
-  std::cout << "===================================" << std::endl;
 }
@@ -4,37 +4,105 @@
 #include "../AST-generation/tokens/token.hpp"
 #include "types/LBPLTypes.hpp"
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+// Top-level names are the only ones the resolver can't turn into a slot, so
+// they are still looked up by name.
+class GlobalEnvironment {
+public:
+  std::unordered_map<Symbol, Value> env;
+
+public:
+  void define(Symbol, Value &);
+  void define(Symbol, Value &&);
+
+  void printEnv(const std::string &&);
+
+  Value get(const Token *);
+  void assign(const Token *, Value &);
+  void assign(const Token *, Value &&);
+};
+
+// A local scope, its variables are numbered by the resolver which also
+// decides how many of them the scope needs. Closures capture single
+// variables rather than whole scopes, so environments never outlive their
+// block and all of them live in an `EnvironmentArena`, with the values stored
+// right after the environment itself.
 class Environment {
 public:
-  std::map<std::string, Value> env;
-  std::shared_ptr<Environment> enclosing;
+  Value *values;
+  Environment *enclosing;
+  uint32_t slotCount;
 
 public:
-  Environment() : enclosing(nullptr) {}
-  Environment(Environment &other)
-      : env(other.env),
-        enclosing(other.enclosing ? other.enclosing->clone() : nullptr) {}
-  Environment(std::shared_ptr<Environment> &enclosing) : enclosing(enclosing) {}
-
-  std::shared_ptr<Environment> clone() {
-    return std::make_shared<Environment>(*this);
+  Environment(Value *values, size_t slotCount, Environment *enclosing)
+      : values(values), enclosing(enclosing), slotCount(slotCount) {
+    for (size_t i = 0; i < slotCount; i++) {
+      values[i] = nullptr;
+    }
   }
 
-  void define(const std::string &, Value &);
-  void define(const std::string &, Value &&);
+  inline Value &at(int depth, int slot) {
+    Environment *env = this;
+    for (; depth > 0; depth--) {
+      env = env->enclosing;
+    }
+
+    return env->values[slot];
+  }
 
+  // Marks the values of the scope.
+  void trace(Heap &);
   void printEnv(const std::string &&);
+};
+
+// Stack of environments. They are bump-allocated in chunks that are kept
+// around once freed, so entering a block or calling a function never calls
+// malloc. Environments are released in the reverse order of allocation by
+// going back to a `Mark`.
+class EnvironmentArena {
+public:
+  struct Mark {
+    size_t chunk;
+    size_t used;
+  };
+
+private:
+  struct Chunk {
+    std::unique_ptr<std::byte[]> memory;
+    size_t capacity;
+    size_t used;
+  };
+
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+  std::vector<Chunk> chunks;
+  size_t current;
+
+private:
+  static inline size_t bytesFor(size_t slotCount) {
+    return sizeof(Environment) + slotCount * sizeof(Value);
+  }
+
+public:
+  EnvironmentArena() : chunks(), current(0) {
+    chunks.push_back(
+        {std::make_unique<std::byte[]>(CHUNK_SIZE), CHUNK_SIZE, 0});
+  }
+  EnvironmentArena(const EnvironmentArena &) = delete;
+
+  Environment *allocate(size_t slotCount, Environment *enclosing);
+
+  inline Mark mark() const { return {current, chunks[current].used}; }
+  void release(Mark);
 
-  Value get(std::shared_ptr<const Token> &);
-  Value getAt(int, std::shared_ptr<const Token> &);
-  Value getAt(int, const std::string &);
-  void assign(std::shared_ptr<const Token> &, Value &);
-  void assign(std::shared_ptr<const Token> &, Value &&);
-  void assignAt(int, std::shared_ptr<const Token> &, Value &);
+  // Marks what the live environments reference, they are roots of the heap.
+  void trace(Heap &);
 };
 
 #endif
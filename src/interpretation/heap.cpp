@@ -0,0 +1,102 @@
+#include "heap.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+Heap heap;
+
+Heap::~Heap() {
+  while (objects) {
+    LBPLObject *next = objects->nextObject;
+    delete objects;
+    objects = next;
+  }
+}
+
+void Heap::addRoots(GCRoots *engine) { roots.push_back(engine); }
+
+void Heap::removeRoots(GCRoots *engine) {
+  roots.erase(std::remove(roots.begin(), roots.end(), engine), roots.end());
+}
+
+LBPLString *Heap::literal(Symbol text) {
+  LBPLString *&string = literals[text];
+  if (!string) {
+    string = allocate<LBPLString>(text.str());
+  }
+  return string;
+}
+
+void Heap::resize(LBPLObject *object, size_t size) {
+  bytesAllocated += size - object->size;
+  object->size = size;
+}
+
+void Heap::markObject(LBPLObject *object) {
+  if (!object || object->marked) {
+    return;
+  }
+
+  object->marked = true;
+  grayStack.push_back(object);
+}
+
+void Heap::markRoots() {
+  for (auto &&[text, string] : literals) {
+    markObject(string);
+  }
+  for (auto &&engine : roots) {
+    engine->markRoots(*this);
+  }
+}
+
+void Heap::traceReferences() {
+  while (!grayStack.empty()) {
+    LBPLObject *object = grayStack.back();
+    grayStack.pop_back();
+    object->trace(*this);
+  }
+}
+
+void Heap::sweep() {
+  LBPLObject **link = &objects;
+
+  while (*link) {
+    LBPLObject *object = *link;
+
+    if (object->marked) {
+      object->marked = false;
+      link = &object->nextObject;
+    } else {
+      *link = object->nextObject;
+      bytesAllocated -= object->size;
+      stats.freedBytes += object->size;
+      delete object;
+    }
+  }
+}
+
+void Heap::collect() {
+  auto start = std::chrono::steady_clock::now();
+
+  markRoots();
+  traceReferences();
+  sweep();
+
+  nextGC = std::max(minHeapSize,
+                    static_cast<size_t>(bytesAllocated * growthFactor));
+
+  double pause = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  stats.collections++;
+  stats.liveBytes = bytesAllocated;
+  stats.totalPauseMs += pause;
+  stats.maxPauseMs = std::max(stats.maxPauseMs, pause);
+}
+
+Heap::Stats Heap::getStats() const {
+  Stats current = stats;
+  current.heapBytes = bytesAllocated;
+  return current;
+}
@@ -0,0 +1,113 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "../AST-generation/tokens/symbol.hpp"
+#include "types/LBPLString.hpp"
+#include "types/LBPLTypes.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Heap;
+
+// Implemented by whatever executes code: it knows which values are still in
+// use and marks them when the heap asks.
+class GCRoots {
+public:
+  virtual ~GCRoots() {}
+  virtual void markRoots(Heap &) = 0;
+};
+
+// Owns every object a `Value` can point to and reclaims the unreachable ones
+// with a mark-sweep collection. Allocating never collects by itself, engines
+// call `collect` at points where all of their live values are visible to
+// `markRoots`.
+class Heap {
+public:
+  struct Stats {
+    size_t collections;
+    double totalPauseMs;
+    double maxPauseMs;
+    // Bytes that survived the last collection and bytes in use right now.
+    size_t liveBytes;
+    size_t heapBytes;
+    size_t freedBytes;
+  };
+
+private:
+  LBPLObject *objects;
+  std::vector<LBPLObject *> grayStack;
+  std::vector<GCRoots *> roots;
+  // Strings of the literals in the program, they live as long as the heap.
+  std::unordered_map<Symbol, LBPLString *> literals;
+
+  size_t bytesAllocated;
+  size_t nextGC;
+  Stats stats;
+
+public:
+  // After a collection the next one happens once the heap has grown by this
+  // factor over what survived, but never below `minHeapSize` bytes.
+  double growthFactor;
+  size_t minHeapSize;
+
+private:
+  void markRoots();
+  void traceReferences();
+  void sweep();
+
+public:
+  Heap()
+      : objects(nullptr), grayStack(), roots(), literals(), bytesAllocated(0),
+        nextGC(1024 * 1024), stats({0, 0, 0, 0, 0, 0}), growthFactor(2),
+        minHeapSize(1024 * 1024) {}
+  Heap(const Heap &) = delete;
+  ~Heap();
+
+  template <typename T, typename... Args> T *allocate(Args &&...args) {
+    T *object = new T(std::forward<Args>(args)...);
+    object->size = sizeof(T);
+    if constexpr (std::is_same_v<T, LBPLString>) {
+      object->size += object->capacity();
+    }
+
+    object->nextObject = objects;
+    objects = object;
+    bytesAllocated += object->size;
+    return object;
+  }
+
+  // The string of a literal, made the first time it's asked for and then
+  // shared by every evaluation of any literal with the same text.
+  LBPLString *literal(Symbol text);
+
+  inline bool shouldCollect() const {
+#ifdef DEBUG_STRESS_GC
+    return true;
+#else
+    return bytesAllocated > nextGC;
+#endif
+  }
+  void collect();
+  // For objects that grow after they were allocated.
+  void resize(LBPLObject *, size_t size);
+
+  void addRoots(GCRoots *);
+  void removeRoots(GCRoots *);
+
+  void markObject(LBPLObject *);
+  inline void markValue(const Value &value) {
+    if (value.isObj()) {
+      markObject(value.asObj());
+    }
+  }
+
+  Stats getStats() const;
+};
+
+extern Heap heap;
+
+#endif
@@ -0,0 +1,21 @@
+#include "inline_cache.hpp"
+
+void printCacheSites(std::ostream &os, const std::vector<CacheSite> &sites) {
+  os << "Inline caches (hits/misses, shapes):" << std::endl;
+
+  for (auto &&site : sites) {
+    const InlineCache *cache = site.cache;
+    if (cache->hits + cache->misses == 0) {
+      continue;
+    }
+
+    os << "  " << site.location.filename << ":" << site.location.line << ":"
+       << site.location.column << " " << site.kind << " " << site.name << ": "
+       << cache->hits << "/" << cache->misses << ", "
+       << static_cast<int>(cache->count);
+    if (cache->megamorphic) {
+      os << " megamorphic";
+    }
+    os << std::endl;
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef INLINE_CACHE_H
+#define INLINE_CACHE_H
+
+#include "../AST-generation/tokens/token.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class LBPLCallable;
+class Shape;
+
+// Remembers what looking up a name found on the last few instance shapes a
+// field access, field store or method call saw. Shapes belong to a single
+// class, so the shape alone tells both where a field is and which method the
+// class has.
+struct InlineCache {
+  static constexpr int ENTRIES = 4;
+
+  struct Entry {
+    uint32_t shapeId;
+    // Slot of the field, -1 when the name is the class' `method` instead.
+    int slot;
+    LBPLCallable *method;
+    // Set for stores that add the field, the shape the instance moves to.
+    Shape *transition;
+  };
+
+  Entry entries[ENTRIES];
+  uint8_t count;
+  uint64_t hits, misses;
+  // Set once the site has seen more shapes than it can remember.
+  bool megamorphic;
+
+  InlineCache() : count(0), hits(0), misses(0), megamorphic(false) {}
+
+  inline const Entry *find(uint32_t shapeId) {
+    for (int i = 0; i < count; i++) {
+      if (entries[i].shapeId == shapeId) {
+        hits++;
+        return &entries[i];
+      }
+    }
+
+    misses++;
+    return nullptr;
+  }
+
+  inline void add(const Entry &entry) {
+    if (count < ENTRIES) {
+      entries[count++] = entry;
+    } else {
+      megamorphic = true;
+    }
+  }
+};
+
+// A cache and the code it belongs to, reported by `--ic-stats`.
+struct CacheSite {
+  const char *kind;
+  std::string name;
+  SourceLocation location;
+  const InlineCache *cache;
+};
+
+void printCacheSites(std::ostream &, const std::vector<CacheSite> &);
+
+#endif
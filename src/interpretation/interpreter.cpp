@@ -1,20 +1,23 @@
 #include "interpreter.hpp"
+#include "operations.hpp"
 #include "runtime_error.hpp"
 #include "types/LBPLClass.hpp"
 #include "types/LBPLFunction.hpp"
 #include "types/LBPLInstance.hpp"
+#include "types/LBPLString.hpp"
 #include "types/LBPLTypes.hpp"
 
 #include <cstddef>
 #include <cstdint>
-#include <map>
+#include <unordered_map>
 #include <memory>
 #include <string>
 #include <variant>
 
-void Interpreter::interpret(std::vector<std::unique_ptr<Stmt>> &stmts) {
+void Interpreter::interpret(std::span<Stmt *> stmts) {
   try {
     for (auto &&stmt : stmts) {
+      safepoint();
       stmt->accept(this);
     }
   } catch (RuntimeError &e) {
@@ -22,13 +25,16 @@ void Interpreter::interpret(std::vector<std::unique_ptr<Stmt>> &stmts) {
   }
 }
 
-void Interpreter::resolve(Expr *expr, int depth) {
-  locals.insert_or_assign(expr, depth);
+void Interpreter::define(int slot, const Token *name, Value &&value) {
+  if (slot < 0) {
+    global.define(name->symbol, value);
+  } else {
+    currentEnv->values[slot] = value;
+  }
 }
 
 void Interpreter::visitFnStmt(FnStmt *stmt) {
-  currentEnv->define(std::get<const char *>(stmt->name->lexeme),
-                     std::make_shared<LBPLFunc>(stmt, currentEnv, false));
+  define(stmt->slot, stmt->name, makeClosure(stmt, false));
 }
 
 void Interpreter::visitVarStmt(VarStmt *stmt) {
@@ -37,48 +43,52 @@ void Interpreter::visitVarStmt(VarStmt *stmt) {
     value = stmt->value->accept(this);
   }
 
-  currentEnv->define(std::get<const char *>(stmt->name->lexeme), value);
+  define(stmt->slot, stmt->name, std::move(value));
 }
 
 void Interpreter::visitClassStmt(ClassStmt *stmt) {
   Value superclass;
-  currentEnv->define(std::get<const char *>(stmt->name->lexeme), nullptr);
+  auto mark = arena.mark();
+  define(stmt->slot, stmt->name, nullptr);
 
   if (stmt->superclass) {
     superclass = stmt->superclass->accept(this);
-    if (!std::holds_alternative<std::shared_ptr<LBPLClass>>(superclass)) {
-      throw RuntimeError(stmt->superclass.get(),
+    if (!superclass.isClass()) {
+      throw RuntimeError(stmt->superclass,
                          "Superclass must be another class.");
     }
 
-    currentEnv = std::make_shared<Environment>(currentEnv);
-    currentEnv->define("super",
-                       std::get<std::shared_ptr<LBPLClass>>(superclass));
+    currentEnv = newEnvironment(1, currentEnv);
+    currentEnv->values[0] = superclass;
   }
 
-  std::map<std::string, LBPLFunc *> methods;
+  std::unordered_map<Symbol, LBPLCallable *> methods;
   for (auto &&methodStmt : stmt->body) {
-    auto method = dynamic_cast<FnStmt *>(methodStmt.get());
+    auto method = dynamic_cast<FnStmt *>(methodStmt);
     if (!method) {
-      throw RuntimeError(methodStmt.get(), "Excepted class method.");
+      throw RuntimeError(methodStmt, "Excepted class method.");
     }
 
-    auto namestr = std::get<const char *>(method->name->lexeme);
-    auto fn = new LBPLFunc(method, currentEnv, std::string(namestr) == "init");
-    methods.insert(std::make_pair(namestr, fn));
+    Symbol name = method->name->symbol;
+    methods.insert(
+        std::make_pair(name, makeClosure(method, name == Symbol::initName)));
   }
 
+  const std::string &name = stmt->name->symbol.str();
+  LBPLClass *clas;
   if (stmt->superclass) {
+    closeUpvalues(currentEnv);
     currentEnv = currentEnv->enclosing;
-    currentEnv->assign(stmt->name,
-                       std::make_shared<LBPLClass>(
-                           std::get<const char *>(stmt->name->lexeme),
-                           std::get<std::shared_ptr<LBPLClass>>(superclass),
-                           methods));
+    arena.release(mark);
+    clas = heap.allocate<LBPLClass>(name, superclass.as<LBPLClass>(), methods);
+  } else {
+    clas = heap.allocate<LBPLClass>(name, methods);
+  }
+
+  if (stmt->slot < 0) {
+    global.assign(stmt->name, clas);
   } else {
-    currentEnv->assign(
-        stmt->name, std::make_shared<LBPLClass>(
-                        std::get<const char *>(stmt->name->lexeme), methods));
+    currentEnv->values[stmt->slot] = clas;
   }
 }
 
@@ -91,158 +101,214 @@ void Interpreter::visitIfStmt(IfStmt *stmt) {
 }
 
 void Interpreter::visitWhileStmt(WhileStmt *stmt) {
-  try {
-    while (isTruthy(stmt->condition->accept(this))) {
-      try {
-        stmt->body->accept(this);
-      } catch (ContinueException &e) {
-      }
+  while (isTruthy(stmt->condition->accept(this))) {
+    safepoint();
+    stmt->body->accept(this);
+
+    if (completion == Completion::Continue) {
+      completion = Completion::Normal;
+    } else if (completion != Completion::Normal) {
+      break;
     }
-  } catch (BreakException &e) {
+  }
+
+  if (completion == Completion::Break) {
+    completion = Completion::Normal;
   }
 }
 
 void Interpreter::visitForStmt(ForStmt *stmt) {
   auto env = currentEnv;
-  currentEnv = std::make_shared<Environment>(currentEnv);
+  auto mark = arena.mark();
+  currentEnv = newEnvironment(stmt->scopeSize, currentEnv);
 
-  stmt->initializer->accept(this);
+  if (stmt->initializer) {
+    stmt->initializer->accept(this);
+  }
 
-  try {
-    while (isTruthy(stmt->condition->accept(this))) {
-      try {
-        stmt->body->accept(this);
-      } catch (ContinueException &e) {
-      }
+  while (isTruthy(stmt->condition->accept(this))) {
+    safepoint();
+    stmt->body->accept(this);
+
+    if (completion == Completion::Continue) {
+      completion = Completion::Normal;
+    } else if (completion != Completion::Normal) {
+      break;
+    }
 
+    if (stmt->increment) {
       stmt->increment->accept(this);
     }
-  } catch (BreakException &e) {
   }
 
+  if (completion == Completion::Break) {
+    completion = Completion::Normal;
+  }
+
+  if (stmt->captured) {
+    closeUpvalues(currentEnv);
+  }
   currentEnv = env;
+  arena.release(mark);
 }
 
 void Interpreter::visitScopedStmt(ScopedStmt *stmt) {
-  executeBlock(stmt->body, std::make_shared<Environment>(currentEnv));
+  auto mark = arena.mark();
+  auto env = newEnvironment(stmt->scopeSize, currentEnv);
+
+  executeBlock(stmt->body, env);
+  if (stmt->captured) {
+    closeUpvalues(env);
+  }
+  arena.release(mark);
 }
 
 void Interpreter::visitExprStmt(ExprStmt *stmt) { stmt->expr->accept(this); }
 void Interpreter::visitReturnStmt(ReturnStmt *stmt) {
-  throw ReturnException(stmt->value->accept(this));
+  returnValue = stmt->value ? stmt->value->accept(this) : nullptr;
+  if (completion != Completion::TailCall) {
+    completion = Completion::Return;
+  }
 }
 
 Value Interpreter::visitBinaryExpr(BinaryExpr *expr) {
   Value left = expr->left->accept(this);
+
+  // The right operand is only evaluated when the left one doesn't decide the
+  // result, which is then the last operand evaluated.
+  if (expr->op->type == TokenType::And) {
+    return isTruthy(left) ? expr->right->accept(this) : left;
+  } else if (expr->op->type == TokenType::Or) {
+    return isTruthy(left) ? left : expr->right->accept(this);
+  }
+
+  pushRoot(left);
   Value right = expr->right->accept(this);
+  popRoot();
 
-  return performBinaryOperation(expr->op, left, right);
+  return performBinaryOperation(expr->op->type, left, right,
+                                {expr->op->line, expr->op->column,
+                                 expr->op->filename()});
 }
 
-Value Interpreter::visitBreakExpr(BreakExpr *) { throw BreakException(); }
+Value Interpreter::visitBreakExpr(BreakExpr *) {
+  completion = Completion::Break;
+  return nullptr;
+}
 Value Interpreter::visitContinueExpr(ContinueExpr *) {
-  throw ContinueException();
+  completion = Completion::Continue;
+  return nullptr;
 }
 
 Value Interpreter::visitUnaryExpr(UnaryExpr *expr) {
-  Value right = expr->right->accept(this);
-
-  if (expr->op->type == TokenType::Minus) {
-    if (std::holds_alternative<int>(right)) {
-      return -std::get<int>(right);
-    } else if (std::holds_alternative<double>(right)) {
-      return -std::get<double>(right);
-    }
-  } else if (expr->op->type == TokenType::Bang) {
-    return !isTruthy(right);
-  }
-
-  return nullptr;
+  return performUnaryOperation(expr->op->type, expr->right->accept(this));
 }
 
 Value Interpreter::visitLiteralExpr(LiteralExpr *expr) {
-  if (expr->token->type == TokenType::True) {
-    return true;
-  } else if (expr->token->type == TokenType::False) {
-    return false;
-  } else if (expr->token->type == TokenType::Nil) {
-    return nullptr;
-  } else if (expr->token->type == TokenType::Char) {
-    return std::get<char>(expr->token->lexeme);
-  } else if (expr->token->type == TokenType::String) {
-    return std::get<const char *>(expr->token->lexeme);
-  } else if (expr->token->type == TokenType::Number) {
-    if (std::holds_alternative<float>(expr->token->lexeme)) {
-      return std::get<float>(expr->token->lexeme);
-    } else {
-      return std::get<int32_t>(expr->token->lexeme);
-    }
-  } else if (expr->token->type == TokenType::Identifier) {
-    return lookupVariable(expr->token, expr);
+  if (expr->string) {
+    return heap.literal(*expr->string);
   }
 
-  return nullptr;
+  return expr->value;
 }
 
 Value Interpreter::visitGroupExpr(GroupingExpr *expr) {
   return expr->expr->accept(this);
 }
 
-Value Interpreter::visitSuperExpr(SuperExpr *) { return nullptr; }
+Value Interpreter::visitSuperExpr(SuperExpr *expr) {
+  auto superclass =
+      lookupLocal(expr->depth, expr->slot, expr->upvalue).as<LBPLClass>();
+  auto instance = lookupLocal(expr->thisDepth, expr->thisSlot,
+                              expr->thisUpvalue)
+                      .as<LBPLInstance>();
+
+  Symbol name = expr->field->symbol;
+  if (auto method = superclass->findMethod(name)) {
+    return method->bind(instance);
+  }
+
+  throw RuntimeError(expr->field, "Undefined field '" + name.str() + "'.");
+}
+
 Value Interpreter::visitThisExpr(ThisExpr *expr) {
-  return lookupVariable(expr->keyword, expr);
+  return lookupVariable(expr->keyword, expr->depth, expr->slot,
+                        expr->upvalue);
 }
 
 Value Interpreter::visitCallExpr(FnCallExpr *expr) {
+  size_t base = roots.size();
   Value callee = expr->callee->accept(this);
-
-  std::vector<Value> args;
-  args.reserve(expr->args.size());
+  pushRoot(callee);
 
   for (auto &&arg : expr->args) {
-    args.emplace_back(arg->accept(this));
+    pushRoot(arg->accept(this));
   }
 
-  if (std::holds_alternative<std::shared_ptr<LBPLCallable>>(callee)) {
-    auto function = std::get<std::shared_ptr<LBPLCallable>>(callee);
-    if (function->arity() != args.size()) {
-      throw RuntimeError(expr->callee.get(), "Wrong number of arguments.");
+  std::vector<Value> args(roots.begin() + base + 1, roots.end());
+  int argc = static_cast<int>(args.size());
+  roots.resize(base);
+
+  if (callee.isCallable()) {
+    auto function = callee.as<LBPLCallable>();
+    if (function->arity() != argc) {
+      throw RuntimeError(expr->callee, "Wrong number of arguments.");
+    }
+
+    if (expr->isTailCall && function->type == CallableType::Function) {
+      tailCallee = function;
+      tailArgs = std::move(args);
+      completion = Completion::TailCall;
+      return nullptr;
     }
 
     return function->call(this, args);
-  } else if (std::holds_alternative<std::shared_ptr<LBPLClass>>(callee)) {
-    auto clas = std::get<std::shared_ptr<LBPLClass>>(callee);
-    if (clas->arity() != args.size()) {
-      throw RuntimeError(expr->callee.get(), "Wrong number of arguments.");
+  } else if (callee.isClass()) {
+    auto clas = callee.as<LBPLClass>();
+    if (clas->arity() != argc) {
+      throw RuntimeError(expr->callee, "Wrong number of arguments.");
     }
 
     return clas->call(this, args);
   }
 
-  throw RuntimeError(expr->callee.get(),
+  throw RuntimeError(expr->callee,
                      "Can only call a function or class initializer.");
 }
 
 Value Interpreter::visitGetFieldExpr(GetFieldExpr *expr) {
   Value instance = expr->instance->accept(this);
-  if (std::holds_alternative<std::shared_ptr<LBPLInstance>>(instance)) {
-    return std::get<std::shared_ptr<LBPLInstance>>(instance)->get(
-        expr->field.get());
+  if (!instance.isInstance()) {
+    throw RuntimeError(expr->instance,
+                       "Only instances of classes can have properties");
+  }
+
+  Symbol name = expr->field->symbol;
+  auto object = instance.as<LBPLInstance>();
+  auto entry = object->lookup(name, expr->cache);
+  addCacheSite("get", expr->field, expr->cache);
+
+  if (entry.slot >= 0) {
+    return object->fields[entry.slot];
+  } else if (entry.method) {
+    return entry.method->bind(object);
   }
 
-  throw RuntimeError(expr->instance.get(),
-                     "Only instances of classes can have properties");
+  throw RuntimeError(expr->field, "Undefined field '" + name.str() + "'.");
 }
 
 Value Interpreter::visitSetFieldExpr(SetFieldExpr *expr) {
   Value instance = expr->instance->accept(this);
 
-  if (std::holds_alternative<std::shared_ptr<LBPLInstance>>(instance)) {
+  if (instance.isInstance()) {
+    pushRoot(instance);
     Value value = expr->value->accept(this);
-    std::get<std::shared_ptr<LBPLInstance>>(instance)->set(expr->field.get(),
-                                                           value);
+    popRoot();
+    instance.as<LBPLInstance>()->store(expr->field->symbol, value,
+                                       expr->cache);
+    addCacheSite("set", expr->field, expr->cache);
   } else {
-    throw RuntimeError(expr->instance.get(),
+    throw RuntimeError(expr->instance,
                        "Only instances of classes can have properties");
   }
 
@@ -258,203 +324,148 @@ Value Interpreter::visitTernaryExpr(TernaryExpr *expr) {
 }
 
 Value Interpreter::visitVarExpr(VariableExpr *expr) {
-  return lookupVariable(expr->variable, expr);
+  return lookupVariable(expr->variable, expr->depth, expr->slot,
+                        expr->upvalue);
 }
 Value Interpreter::visitAssignExpr(AssignExpr *expr) {
   Value value = expr->value->accept(this);
 
-  auto it = locals.find(expr);
-  if (it == locals.end()) {
-    global->assign(expr->variable, value);
+  if (expr->depth < 0 && expr->upvalue < 0) {
+    global.assign(expr->variable, value);
   } else {
-    currentEnv->assignAt(it->second, expr->variable, value);
+    lookupLocal(expr->depth, expr->slot, expr->upvalue) = value;
   }
 
   return value;
 }
 
-void Interpreter::execute(std::unique_ptr<Stmt> &stmt) { stmt->accept(this); }
+void Interpreter::execute(Stmt *stmt) { stmt->accept(this); }
 
-Value Interpreter::evaluate(std::unique_ptr<Expr> &expr) {
+Value Interpreter::evaluate(Expr *expr) {
   return expr->accept(this);
 }
 
-Value Interpreter::performBinaryOperation(std::shared_ptr<const Token> &op,
-                                          const Value &left,
-                                          const Value &right) {
-  auto performIntOp = [](int l, int r,
-                         std::shared_ptr<const Token> &op) -> Value {
-    switch (op->type) {
-    case TokenType::Plus:
-      return l + r;
-    case TokenType::Minus:
-      return l - r;
-    case TokenType::Star:
-      return l * r;
-    case TokenType::Slash:
-      if (r == 0) {
-        throw RuntimeError(op.get(), "Division by zero.");
-      }
-      return l / r;
-    case TokenType::Less:
-      return l < r;
-    case TokenType::LessEqual:
-      return l <= r;
-    case TokenType::Greater:
-      return l > r;
-    case TokenType::GreaterEqual:
-      return l >= r;
-    case TokenType::EqualEqual:
-      return l == r;
-    case TokenType::BangEqual:
-      return l != r;
-    case TokenType::ModOp:
-      if (r == 0) {
-        throw RuntimeError(op.get(), "Modulo by zero.");
-      }
-      return l % r;
-    default:
-      throw RuntimeError(op.get(), "Unsupported binary operation.");
+void Interpreter::executeBlock(std::span<Stmt *> body, Environment *env) {
+  auto prev = currentEnv;
+  currentEnv = env;
+  for (auto &&stmt : body) {
+    safepoint();
+    stmt->accept(this);
+
+    if (completion != Completion::Normal) {
+      break;
     }
-  };
-
-  auto performDoubleOp = [](double l, double r,
-                            std::shared_ptr<const Token> &op) -> Value {
-    switch (op->type) {
-    case TokenType::Plus:
-      return l + r;
-    case TokenType::Minus:
-      return l - r;
-    case TokenType::Star:
-      return l * r;
-    case TokenType::Slash:
-      if (r == 0) {
-        throw RuntimeError(op.get(), "Division by zero.");
-      }
-      return l / r;
-    case TokenType::Less:
-      return l < r;
-    case TokenType::LessEqual:
-      return l <= r;
-    case TokenType::Greater:
-      return l > r;
-    case TokenType::GreaterEqual:
-      return l >= r;
-    case TokenType::EqualEqual:
-      return l == r;
-    case TokenType::BangEqual:
-      return l != r;
-    default:
-      throw RuntimeError(op.get(), "Unsupported binary operation.");
+  }
+
+  currentEnv = prev;
+}
+
+LBPLFunc *Interpreter::makeClosure(FnStmt *stmt, bool isInitializer) {
+  auto fn = heap.allocate<LBPLFunc>(stmt, isInitializer);
+
+  fn->upvalues.reserve(stmt->upvalues.size());
+  for (auto &&ref : stmt->upvalues) {
+    fn->upvalues.push_back(
+        ref.isLocal ? captureUpvalue(&currentEnv->at(ref.depth, ref.index))
+                    : currentFn->upvalues[ref.index]);
+  }
+
+  return fn;
+}
+
+LBPLUpvalue *Interpreter::captureUpvalue(Value *local) {
+  for (auto upvalue = openUpvalues; upvalue; upvalue = upvalue->next) {
+    if (upvalue->location == local) {
+      return upvalue;
     }
-  };
+  }
+
+  auto upvalue = heap.allocate<LBPLUpvalue>(local);
+  upvalue->next = openUpvalues;
+  openUpvalues = upvalue;
+  return upvalue;
+}
+
+void Interpreter::closeUpvalues(Environment *env) {
+  LBPLUpvalue **link = &openUpvalues;
+
+  while (*link) {
+    LBPLUpvalue *upvalue = *link;
 
-  auto performStringOp = [](const std::string &l, const std::string &r,
-                            std::shared_ptr<const Token> &op) -> Value {
-    if (op->type == TokenType::Plus) {
-      return l + r;
+    if (upvalue->location >= env->values &&
+        upvalue->location < env->values + env->slotCount) {
+      upvalue->closed = *upvalue->location;
+      upvalue->location = &upvalue->closed;
+      *link = upvalue->next;
     } else {
-      throw RuntimeError(op.get(), "Unsupported binary operation.");
+      link = &upvalue->next;
     }
-  };
-
-  return std::visit(
-      [&](const auto &l, const auto &r) -> Value {
-        using L = std::decay_t<decltype(l)>;
-        using R = std::decay_t<decltype(r)>;
-
-        if constexpr (std::is_same_v<L, int> && std::is_same_v<R, int>) {
-          return performIntOp(l, r, op);
-        } else if constexpr (std::is_same_v<L, double> &&
-                             std::is_same_v<R, double>) {
-          return performDoubleOp(l, r, op);
-        } else if constexpr ((std::is_same_v<L, std::string> &&
-                              std::is_same_v<R, int>) ||
-                             (std::is_same_v<L, int> &&
-                              std::is_same_v<R, std::string>)) {
-          // Handle int-to-string or string-to-int concatenation
-          std::string leftStr = std::holds_alternative<int>(left)
-                                    ? std::to_string(std::get<int>(left))
-                                    : std::get<std::string>(left);
-          std::string rightStr = std::holds_alternative<int>(right)
-                                     ? std::to_string(std::get<int>(right))
-                                     : std::get<std::string>(right);
-          if (op->type == TokenType::Plus) {
-            return leftStr + rightStr;
-          } else {
-            throw RuntimeError(op.get(), "Unsupported binary operation.");
-          }
-        } else if constexpr ((std::is_same_v<L, std::string> &&
-                              std::is_same_v<R, double>) ||
-                             (std::is_same_v<L, double> &&
-                              std::is_same_v<R, std::string>)) {
-          // Handle double-to-string or string-to-double concatenation
-          std::string leftStr = std::holds_alternative<double>(left)
-                                    ? std::to_string(std::get<double>(left))
-                                    : std::get<std::string>(left);
-          std::string rightStr = std::holds_alternative<double>(right)
-                                     ? std::to_string(std::get<double>(right))
-                                     : std::get<std::string>(right);
-          if (op->type == TokenType::Plus) {
-            return leftStr + rightStr;
-          } else {
-            throw RuntimeError(op.get(), "Unsupported binary operation.");
-          }
-        } else if constexpr (std::is_same_v<L, std::string> &&
-                             std::is_same_v<R, std::string>) {
-          return performStringOp(l, r, op);
-        } else {
-          throw RuntimeError(op.get(), "Unsupported binary operation.");
-        }
-      },
-      left, right);
-}
-
-void Interpreter::executeBlock(std::vector<std::unique_ptr<Stmt>> &body,
-                               std::shared_ptr<Environment> &&env) {
-  executeBlock(body, env);
-}
-
-void Interpreter::executeBlock(std::vector<std::unique_ptr<Stmt>> &body,
-                               std::shared_ptr<Environment> &env) {
-  auto prev = currentEnv;
+  }
+}
 
-  try {
-    currentEnv = env;
-    for (auto &&stmt : body) {
-      stmt->accept(this);
-    }
-  } catch (ReturnException &e) {
-    currentEnv = prev;
-    throw e;
+void Interpreter::addCacheSite(const char *kind, const Token *name,
+                               const InlineCache &cache) {
+  if (cache.hits + cache.misses == 1) {
+    cacheSites.push_back({kind, name->symbol.str(),
+                          {name->line, name->column, name->filename()},
+                          &cache});
   }
+}
 
-  currentEnv = prev;
+bool Interpreter::consumeTailCall(LBPLCallable *&callee,
+                                  std::vector<Value> &args) {
+  if (completion != Completion::TailCall) {
+    return false;
+  }
+
+  completion = Completion::Normal;
+  callee = tailCallee;
+  args = std::move(tailArgs);
+  return true;
 }
 
-bool Interpreter::isTruthy(const Value &value) {
-  if (std::holds_alternative<std::nullptr_t>(value)) {
-    return std::get<std::nullptr_t>(value) != nullptr;
-  } else if (std::holds_alternative<bool>(value)) {
-    return std::get<bool>(value);
-  } else if (std::holds_alternative<int>(value)) {
-    return std::get<int>(value) == 0;
-  } else if (std::holds_alternative<double>(value)) {
-    return std::get<double>(value) == 0;
+Value Interpreter::consumeReturn() {
+  if (completion != Completion::Return) {
+    return nullptr;
+  }
+
+  completion = Completion::Normal;
+  return returnValue;
+}
+
+Value &Interpreter::lookupLocal(int depth, int slot, int upvalue) {
+  if (upvalue >= 0) {
+    return *currentFn->upvalues[upvalue]->location;
   }
 
-  return false;
+  return currentEnv->at(depth, slot);
 }
 
-bool Interpreter::isTruthy(Value &&value) { return isTruthy(value); }
+Value Interpreter::lookupVariable(const Token *name, int depth, int slot,
+                                  int upvalue) {
+  if (depth < 0 && upvalue < 0) {
+    return global.get(name);
+  }
 
-Value Interpreter::lookupVariable(std::shared_ptr<const Token> &name,
-                                  Expr *expr) {
-  auto it = locals.find(expr);
+  return lookupLocal(depth, slot, upvalue);
+}
 
-  if (it == locals.end()) {
-    return global->get(name);
+void Interpreter::markRoots(Heap &heap) {
+  for (auto &&[name, value] : global.env) {
+    heap.markValue(value);
   }
 
-  return currentEnv->getAt(it->second, name);
+  arena.trace(heap);
+  heap.markObject(currentFn);
+  for (auto upvalue = openUpvalues; upvalue; upvalue = upvalue->next) {
+    heap.markObject(upvalue);
+  }
+  heap.markValue(returnValue);
+  heap.markObject(tailCallee);
+  for (auto &&value : tailArgs) {
+    heap.markValue(value);
+  }
+  for (auto &&value : roots) {
+    heap.markValue(value);
+  }
 }
@@ -3,38 +3,63 @@
 
 #include "builtin_methods.hpp"
 #include "environment.hpp"
+#include "heap.hpp"
+#include "inline_cache.hpp"
 #include "types/LBPLTypes.hpp"
+#include "types/LBPLUpvalue.hpp"
 #include "visitor.hpp"
 
 #include <map>
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
-class BreakException {};
-class ContinueException {};
-class ReturnException {
-public:
-  Value value;
+// How the last executed statement completed. Anything other than `Normal`
+// makes enclosing blocks stop early until a loop or a function call consumes
+// it, `return` leaves its value in `Interpreter::returnValue`. A `TailCall`
+// leaves the callee and its arguments to the function being returned from,
+// which runs it in place of itself.
+namespace Completion {
+enum Type { Normal, Return, Break, Continue, TailCall };
+}
 
-public:
-  ReturnException(Value &&value) : value(value) {}
-};
+class LBPLFunc;
 
-class Interpreter : Statement::Visitor, Expression::Visitor {
+class Interpreter : Statement::Visitor, Expression::Visitor, public GCRoots {
 private:
-  std::shared_ptr<Environment> global, currentEnv;
-  std::map<Expr *, int> locals;
+  GlobalEnvironment global;
+  Environment *currentEnv;
+  EnvironmentArena arena;
+  // The function being run, null for top-level code.
+  LBPLFunc *currentFn;
+  // Upvalues still pointing into a live environment.
+  LBPLUpvalue *openUpvalues;
+  Completion::Type completion;
+  Value returnValue;
+  LBPLCallable *tailCallee;
+  std::vector<Value> tailArgs;
+  // Values only referenced by C++ locals while some code runs, collections
+  // happen between statements so they have to be kept alive explicitly.
+  std::vector<Value> roots;
+  // Every field access and store that ran at least once.
+  std::vector<CacheSite> cacheSites;
 
 private:
-  void execute(std::unique_ptr<Stmt> &);
-
-  Value evaluate(std::unique_ptr<Expr> &);
-  Value lookupVariable(std::shared_ptr<const Token> &, Expr *);
-  bool isTruthy(const Value &);
-  bool isTruthy(Value &&);
+  void execute(Stmt *);
+  inline void safepoint() {
+    if (heap.shouldCollect()) {
+      heap.collect();
+    }
+  }
 
-  Value performBinaryOperation(std::shared_ptr<const Token> &, const Value &,
-                               const Value &);
+  Value evaluate(Expr *);
+  void define(int slot, const Token *, Value &&);
+  Value &lookupLocal(int depth, int slot, int upvalue);
+  Value lookupVariable(const Token *, int depth, int slot, int upvalue);
+  LBPLFunc *makeClosure(FnStmt *, bool isInitializer);
+  LBPLUpvalue *captureUpvalue(Value *local);
+  void addCacheSite(const char *kind, const Token *, const InlineCache &);
 
   void visitFnStmt(FnStmt *) override;
   void visitVarStmt(VarStmt *) override;
@@ -62,18 +87,49 @@ private:
   Value visitAssignExpr(AssignExpr *) override;
 
 public:
-  void executeBlock(std::vector<std::unique_ptr<Stmt>> &,
-                    std::shared_ptr<Environment> &);
-  void executeBlock(std::vector<std::unique_ptr<Stmt>> &,
-                    std::shared_ptr<Environment> &&);
-  void interpret(std::vector<std::unique_ptr<Stmt>> &);
-  void resolve(Expr *, int);
+  void executeBlock(std::span<Stmt *>, Environment *);
+  // Environments have to be given back with `releaseScopes` once the code
+  // using them is done, after closing the upvalues of the captured ones.
+  inline Environment *newEnvironment(size_t slotCount,
+                                     Environment *enclosing) {
+    return arena.allocate(slotCount, enclosing);
+  }
+  inline EnvironmentArena::Mark scopeMark() const { return arena.mark(); }
+  inline void releaseScopes(EnvironmentArena::Mark mark) {
+    arena.release(mark);
+  }
+  void closeUpvalues(Environment *);
+  // Returns the function that was running before.
+  inline LBPLFunc *enterFunction(LBPLFunc *fn) {
+    std::swap(fn, currentFn);
+    return fn;
+  }
+  Value consumeReturn();
+  bool consumeTailCall(LBPLCallable *&callee, std::vector<Value> &args);
+  void interpret(std::span<Stmt *>);
+  inline const std::vector<CacheSite> &getCacheSites() const {
+    return cacheSites;
+  }
+
+  inline void pushRoot(Value value) { roots.push_back(value); }
+  inline void popRoot() { roots.pop_back(); }
+  void markRoots(Heap &) override;
 
   Interpreter()
-      : global(std::make_shared<Environment>()), currentEnv(global), locals() {
-    global->define("println", std::make_shared<LBPLPrintln>());
-    global->define("clock", std::make_shared<LBPLClock>());
+      : global(), currentEnv(nullptr), arena(), currentFn(nullptr),
+        openUpvalues(nullptr), completion(Completion::Normal),
+        returnValue(nullptr), tailCallee(nullptr), tailArgs(), roots(),
+        cacheSites() {
+    global.define(Symbol::intern("println"), heap.allocate<LBPLPrintln>());
+    global.define(Symbol::intern("clock"), heap.allocate<LBPLClock>());
+    global.define(Symbol::intern("gcStats"), heap.allocate<LBPLGCStats>());
+    global.define(Symbol::intern("StringBuilder"),
+                  heap.allocate<LBPLNewStringBuilder>());
+    global.define(Symbol::intern("append"), heap.allocate<LBPLAppend>());
+    global.define(Symbol::intern("toString"), heap.allocate<LBPLToString>());
+    heap.addRoots(this);
   }
+  ~Interpreter() { heap.removeRoots(this); }
 };
 
 #endif
@@ -0,0 +1,52 @@
+#include "lazy_functions.hpp"
+#include "../AST-generation/parser.hpp"
+#include "optimizer.hpp"
+#include "resolver.hpp"
+#include "runtime_error.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Opened the first time one of their functions is called.
+static std::unordered_map<uint16_t, std::unique_ptr<Parser>> parsers;
+// Owns the nodes made while optimizing the bodies.
+static Optimizer optimizer;
+
+FnStmt *LazyFunctions::parse(const SourcePosition &position) {
+  const char *path = SourceFiles::name(position.file);
+  SourceLocation where = {position.line, position.column, path};
+  std::unique_ptr<Parser> &parser = parsers[position.file];
+  if (!parser) {
+    parser = std::make_unique<Parser>(path);
+  }
+
+  if (!parser->loaded()) {
+    throw RuntimeError(where, "Couldn't load file '" + std::string(path) +
+                                  "' to parse the function called.");
+  }
+
+  if (FnStmt *fn = parser->deferredFunction(position)) {
+    std::vector<Stmt *> program = {fn};
+    Resolver resolver;
+    resolver.resolve(program);
+
+    if (!resolver.hadError) {
+      // Nothing is known about the globals, the function is kept.
+      optimizer.optimize(program);
+      return fn;
+    }
+  }
+
+  throw RuntimeError(where, "The function called has errors in its body.");
+}
+
+void LazyFunctions::complete(FnStmt *fn) {
+  FnStmt *parsed = parse(fn->deferred->position);
+
+  fn->body = parsed->body;
+  fn->upvalues = parsed->upvalues;
+  fn->scopeSize = parsed->scopeSize;
+  fn->captured = parsed->captured;
+  fn->deferred = nullptr;
+}
@@ -0,0 +1,18 @@
+#ifndef LAZY_FUNCTIONS_H
+#define LAZY_FUNCTIONS_H
+
+#include "../AST-generation/statements.hpp"
+
+// Bodies of the top-level functions the parser skimmed, parsed, resolved and
+// optimized the first time the function is called. The parser of each file
+// is kept, with the AST it builds, until the program ends.
+namespace LazyFunctions {
+// The whole function skimmed at `position`. Errors in its body are printed
+// and stop the program with a runtime error where it's defined.
+FnStmt *parse(const SourcePosition &position);
+
+// Gives a deferred function the body it was skimmed over.
+void complete(FnStmt *fn);
+} // namespace LazyFunctions
+
+#endif
@@ -0,0 +1,139 @@
+#include "operations.hpp"
+#include "heap.hpp"
+#include "types/LBPLString.hpp"
+
+#include <string>
+
+Value performBinaryOperation(TokenType op, const Value &left,
+                             const Value &right, const SourceLocation &where) {
+  auto performIntOp = [&](int l, int r) -> Value {
+    switch (op) {
+    case TokenType::Plus:
+      return l + r;
+    case TokenType::Minus:
+      return l - r;
+    case TokenType::Star:
+      return l * r;
+    case TokenType::Slash:
+      if (r == 0) {
+        throw RuntimeError(where, "Division by zero.");
+      }
+      return l / r;
+    case TokenType::Less:
+      return l < r;
+    case TokenType::LessEqual:
+      return l <= r;
+    case TokenType::Greater:
+      return l > r;
+    case TokenType::GreaterEqual:
+      return l >= r;
+    case TokenType::EqualEqual:
+      return l == r;
+    case TokenType::BangEqual:
+      return l != r;
+    case TokenType::ModOp:
+      if (r == 0) {
+        throw RuntimeError(where, "Modulo by zero.");
+      }
+      return l % r;
+    default:
+      throw RuntimeError(where, "Unsupported binary operation.");
+    }
+  };
+
+  auto performDoubleOp = [&](double l, double r) -> Value {
+    switch (op) {
+    case TokenType::Plus:
+      return l + r;
+    case TokenType::Minus:
+      return l - r;
+    case TokenType::Star:
+      return l * r;
+    case TokenType::Slash:
+      if (r == 0) {
+        throw RuntimeError(where, "Division by zero.");
+      }
+      return l / r;
+    case TokenType::Less:
+      return l < r;
+    case TokenType::LessEqual:
+      return l <= r;
+    case TokenType::Greater:
+      return l > r;
+    case TokenType::GreaterEqual:
+      return l >= r;
+    case TokenType::EqualEqual:
+      return l == r;
+    case TokenType::BangEqual:
+      return l != r;
+    default:
+      throw RuntimeError(where, "Unsupported binary operation.");
+    }
+  };
+
+  auto toString = [](const Value &value) -> LBPLString * {
+    if (value.isString()) {
+      return value.as<LBPLString>();
+    }
+
+    std::string text;
+    appendText(text, value);
+    return heap.allocate<LBPLString>(std::move(text));
+  };
+
+  if (left.isInt() && right.isInt()) {
+    return performIntOp(left.asInt(), right.asInt());
+  } else if (left.isDouble() && right.isDouble()) {
+    return performDoubleOp(left.asDouble(), right.asDouble());
+  } else if ((left.isString() &&
+              (right.isString() || right.isInt() || right.isDouble())) ||
+             (right.isString() && (left.isInt() || left.isDouble()))) {
+    // Strings concatenate with each other and with the textual form of
+    // numbers.
+    if (op == TokenType::Plus) {
+      return LBPLString::concatenate(toString(left), toString(right));
+    }
+  }
+
+  throw RuntimeError(where, "Unsupported binary operation.");
+}
+
+bool appendText(std::string &text, const Value &value) {
+  if (value.isString()) {
+    text += value.as<LBPLString>()->str();
+  } else if (value.isInt()) {
+    text += std::to_string(value.asInt());
+  } else if (value.isDouble()) {
+    text += std::to_string(value.asDouble());
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+Value performUnaryOperation(TokenType op, const Value &right) {
+  if (op == TokenType::Minus) {
+    if (right.isInt()) {
+      return -right.asInt();
+    } else if (right.isDouble()) {
+      return -right.asDouble();
+    }
+  } else if (op == TokenType::Bang) {
+    return !isTruthy(right);
+  }
+
+  return nullptr;
+}
+
+bool isTruthy(const Value &value) {
+  if (value.isBool()) {
+    return value.asBool();
+  } else if (value.isInt()) {
+    return value.asInt() == 0;
+  } else if (value.isDouble()) {
+    return value.asDouble() == 0;
+  }
+
+  return false;
+}
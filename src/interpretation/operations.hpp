@@ -0,0 +1,20 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "../AST-generation/tokens/token_type.hpp"
+#include "runtime_error.hpp"
+#include "types/LBPLTypes.hpp"
+
+#include <string>
+
+// Semantics shared by every execution engine, so that the tree-walking
+// interpreter and the bytecode VM agree on what an operator does.
+Value performBinaryOperation(TokenType op, const Value &left,
+                             const Value &right, const SourceLocation &where);
+Value performUnaryOperation(TokenType op, const Value &right);
+// Appends the text `+` concatenates `value` as, false for values that can't
+// be concatenated.
+bool appendText(std::string &text, const Value &value);
+bool isTruthy(const Value &value);
+
+#endif
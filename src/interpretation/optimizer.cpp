@@ -0,0 +1,355 @@
+#include "optimizer.hpp"
+#include "heap.hpp"
+#include "operations.hpp"
+
+// Strings are the ones the engines evaluate literals to, so that constants go
+// through the same operations as the values they compute.
+static Value valueOf(const LiteralExpr *literal) {
+  if (literal->string) {
+    return heap.literal(*literal->string);
+  }
+
+  return literal->value;
+}
+
+// True when `expr` is the number `value`, bit for bit so that `-0` isn't `0`.
+static bool isConstant(const Expr *expr, double value) {
+  auto literal = dynamic_cast<const LiteralExpr *>(expr);
+  return literal && !literal->string && literal->value == Value(value);
+}
+
+// True when `expr` either evaluates to a double or fails. Arithmetic on a
+// double only succeeds when the other operand is a double too.
+static bool isNumber(const Expr *expr) {
+  if (auto literal = dynamic_cast<const LiteralExpr *>(expr)) {
+    return !literal->string && literal->value.isDouble();
+  } else if (auto unary = dynamic_cast<const UnaryExpr *>(expr)) {
+    return unary->op->type == TokenType::Minus && isNumber(unary->right);
+  } else if (auto ternary = dynamic_cast<const TernaryExpr *>(expr)) {
+    return isNumber(ternary->trueBranch) && isNumber(ternary->falseBranch);
+  } else if (auto binary = dynamic_cast<const BinaryExpr *>(expr)) {
+    switch (binary->op->type) {
+    case TokenType::Minus:
+    case TokenType::Star:
+    case TokenType::Slash:
+      return isNumber(binary->left) || isNumber(binary->right);
+    case TokenType::Plus:
+      // Strings concatenate with numbers.
+      return isNumber(binary->left) && isNumber(binary->right);
+    default:
+      return false;
+    }
+  }
+
+  return false;
+}
+
+// True when evaluating `expr` can't fail or have an effect.
+static bool isPure(const Expr *expr) {
+  if (dynamic_cast<const LiteralExpr *>(expr) ||
+      dynamic_cast<const ThisExpr *>(expr)) {
+    return true;
+  } else if (auto var = dynamic_cast<const VariableExpr *>(expr)) {
+    // Globals may not be defined yet.
+    return var->depth >= 0 || var->upvalue >= 0;
+  }
+
+  return false;
+}
+
+// True when the statements after `stmt` can't be reached.
+static bool isJump(const Stmt *stmt) {
+  if (dynamic_cast<const ReturnStmt *>(stmt)) {
+    return true;
+  } else if (auto exprStmt = dynamic_cast<const ExprStmt *>(stmt)) {
+    return dynamic_cast<const BreakExpr *>(exprStmt->expr) ||
+           dynamic_cast<const ContinueExpr *>(exprStmt->expr);
+  }
+
+  return false;
+}
+
+void Optimizer::optimize(std::vector<Stmt *> &program) {
+  program.resize(optimize(std::span<Stmt *>(program)).size());
+}
+
+std::span<Stmt *> Optimizer::optimize(std::span<Stmt *> body) {
+  size_t kept = 0;
+  for (auto &&stmt : body) {
+    if (Stmt *optimized = optimize(stmt)) {
+      body[kept++] = optimized;
+      if (isJump(optimized)) {
+        break;
+      }
+    }
+  }
+
+  return body.first(kept);
+}
+
+Stmt *Optimizer::optimize(Stmt *stmt) {
+  stmt->accept(this);
+  return replacement;
+}
+
+Stmt *Optimizer::optimizeBranch(Stmt *stmt) {
+  if (Stmt *optimized = optimize(stmt)) {
+    return optimized;
+  }
+
+  return nodes.make<ScopedStmt>(stmt->location, std::span<Stmt *>());
+}
+
+Expr *Optimizer::optimize(Expr *expr) {
+  expr->accept(this);
+  return result;
+}
+
+// Null when the value can't be written as a literal.
+Expr *Optimizer::constant(const Token *location, const Value &value) {
+  if (value.isString()) {
+    return nodes.make<LiteralExpr>(
+        location, Symbol::intern(value.as<LBPLString>()->str()));
+  } else if (!value.isObj()) {
+    return nodes.make<LiteralExpr>(location, value);
+  }
+
+  return nullptr;
+}
+
+void Optimizer::visitFnStmt(FnStmt *fn) {
+  bool used = fn->slot >= 0 ? fn->used
+                            : !usedGlobals ||
+                                  usedGlobals->contains(fn->name->symbol);
+  if (!used) {
+    replacement = nullptr;
+    return;
+  }
+
+  fn->body = optimize(fn->body);
+  replacement = fn;
+}
+
+void Optimizer::visitVarStmt(VarStmt *var) {
+  if (var->value) {
+    var->value = optimize(var->value);
+  }
+
+  bool pure = !var->value || isPure(var->value);
+  replacement = var->slot >= 0 && !var->used && pure ? nullptr : var;
+}
+
+void Optimizer::visitClassStmt(ClassStmt *clas) {
+  for (auto &&stmt : clas->body) {
+    auto method = dynamic_cast<FnStmt *>(stmt);
+    method->body = optimize(method->body);
+  }
+
+  replacement = clas;
+}
+
+void Optimizer::visitIfStmt(IfStmt *stmt) {
+  stmt->condition = optimize(stmt->condition);
+
+  // Only the branch that's taken is kept, and optimized.
+  if (auto condition = dynamic_cast<LiteralExpr *>(stmt->condition)) {
+    Stmt *taken = isTruthy(valueOf(condition)) ? stmt->trueBranch
+                                               : stmt->falseBranch;
+    replacement = taken ? optimize(taken) : nullptr;
+    return;
+  }
+
+  stmt->trueBranch = optimizeBranch(stmt->trueBranch);
+  if (stmt->falseBranch) {
+    stmt->falseBranch = optimize(stmt->falseBranch);
+  }
+  replacement = stmt;
+}
+
+void Optimizer::visitWhileStmt(WhileStmt *loop) {
+  loop->condition = optimize(loop->condition);
+
+  auto condition = dynamic_cast<LiteralExpr *>(loop->condition);
+  if (condition && !isTruthy(valueOf(condition))) {
+    replacement = nullptr;
+    return;
+  }
+
+  loop->body = optimizeBranch(loop->body);
+  replacement = loop;
+}
+
+void Optimizer::visitForStmt(ForStmt *loop) {
+  if (loop->initializer) {
+    loop->initializer = optimize(loop->initializer);
+  }
+  loop->condition = optimize(loop->condition);
+
+  // The initializer is in the loop's scope, it can't be moved out of it.
+  auto condition = dynamic_cast<LiteralExpr *>(loop->condition);
+  if (condition && !isTruthy(valueOf(condition)) && !loop->initializer) {
+    replacement = nullptr;
+    return;
+  }
+
+  if (loop->increment) {
+    loop->increment = optimize(loop->increment);
+  }
+  loop->body = optimizeBranch(loop->body);
+  replacement = loop;
+}
+
+void Optimizer::visitScopedStmt(ScopedStmt *block) {
+  block->body = optimize(block->body);
+  replacement = block->body.empty() ? nullptr : block;
+}
+
+void Optimizer::visitExprStmt(ExprStmt *stmt) {
+  stmt->expr = optimize(stmt->expr);
+  replacement = isPure(stmt->expr) ? nullptr : stmt;
+}
+
+void Optimizer::visitReturnStmt(ReturnStmt *ret) {
+  if (ret->value) {
+    ret->value = optimize(ret->value);
+  }
+  replacement = ret;
+}
+
+Value Optimizer::visitBinaryExpr(BinaryExpr *expr) {
+  expr->left = optimize(expr->left);
+  expr->right = optimize(expr->right);
+  result = expr;
+
+  auto left = dynamic_cast<LiteralExpr *>(expr->left);
+  auto right = dynamic_cast<LiteralExpr *>(expr->right);
+  if (left && right) {
+    try {
+      Value value = performBinaryOperation(expr->op->type, valueOf(left),
+                                           valueOf(right),
+                                           expr->op->location());
+      if (Expr *folded = constant(expr->location, value)) {
+        result = folded;
+      }
+    } catch (RuntimeError &) {
+      // Reported by the engine, if the expression is ever evaluated.
+    }
+    return nullptr;
+  }
+
+  // `x + 0` isn't `x` when `x` is `-0`.
+  switch (expr->op->type) {
+  case TokenType::Star:
+    if (isConstant(expr->right, 1) && isNumber(expr->left)) {
+      result = expr->left;
+    } else if (isConstant(expr->left, 1) && isNumber(expr->right)) {
+      result = expr->right;
+    }
+    break;
+  case TokenType::Slash:
+    if (isConstant(expr->right, 1) && isNumber(expr->left)) {
+      result = expr->left;
+    }
+    break;
+  case TokenType::Minus:
+    if (isConstant(expr->right, 0) && isNumber(expr->left)) {
+      result = expr->left;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return nullptr;
+}
+
+Value Optimizer::visitBreakExpr(BreakExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitContinueExpr(ContinueExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitUnaryExpr(UnaryExpr *expr) {
+  expr->right = optimize(expr->right);
+  result = expr;
+
+  if (auto right = dynamic_cast<LiteralExpr *>(expr->right)) {
+    Value value = performUnaryOperation(expr->op->type, valueOf(right));
+    if (Expr *folded = constant(expr->location, value)) {
+      result = folded;
+    }
+  }
+  return nullptr;
+}
+
+Value Optimizer::visitLiteralExpr(LiteralExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitGroupExpr(GroupingExpr *expr) {
+  result = optimize(expr->expr);
+  return nullptr;
+}
+
+Value Optimizer::visitSuperExpr(SuperExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitThisExpr(ThisExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitCallExpr(FnCallExpr *expr) {
+  expr->callee = optimize(expr->callee);
+  for (auto &&arg : expr->args) {
+    arg = optimize(arg);
+  }
+
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitGetFieldExpr(GetFieldExpr *expr) {
+  expr->instance = optimize(expr->instance);
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitSetFieldExpr(SetFieldExpr *expr) {
+  expr->value = optimize(expr->value);
+  expr->instance = optimize(expr->instance);
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitTernaryExpr(TernaryExpr *expr) {
+  expr->condition = optimize(expr->condition);
+  expr->trueBranch = optimize(expr->trueBranch);
+  expr->falseBranch = optimize(expr->falseBranch);
+
+  if (auto condition = dynamic_cast<LiteralExpr *>(expr->condition)) {
+    result = isTruthy(valueOf(condition)) ? expr->trueBranch
+                                          : expr->falseBranch;
+  } else {
+    result = expr;
+  }
+  return nullptr;
+}
+
+Value Optimizer::visitVarExpr(VariableExpr *expr) {
+  result = expr;
+  return nullptr;
+}
+
+Value Optimizer::visitAssignExpr(AssignExpr *expr) {
+  expr->value = optimize(expr->value);
+  result = expr;
+  return nullptr;
+}
@@ -0,0 +1,77 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "../AST-generation/ast_arena.hpp"
+#include "../AST-generation/statements.hpp"
+#include "visitor.hpp"
+
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+// Rewrites the resolved AST before it's executed. Operations on constants
+// are folded with the semantics of the engines, so an operation that would
+// fail at runtime, like a division by zero, is left to fail there. Grouping
+// parentheses are dropped, identities like `x * 1` are simplified when `x`
+// can only be a number, and ternaries with a constant condition are replaced
+// by the branch they'd take.
+//
+// Dead code is then removed using what the resolver found: branches and
+// loops a constant condition never runs, statements after a `return`,
+// `break` or `continue`, expression statements without effects, and locals
+// and functions that are never referred to.
+class Optimizer : Statement::Visitor, Expression::Visitor {
+private:
+  // Null when any global may be used, like in a function parsed on its own.
+  const std::unordered_set<Symbol> *usedGlobals;
+  // Nodes made by the optimizer, they have to live as long as the AST.
+  AstArena nodes;
+  // What the expression or statement being visited is replaced with, a null
+  // statement is removed.
+  Expr *result;
+  Stmt *replacement;
+
+private:
+  Expr *optimize(Expr *);
+  Expr *constant(const Token *location, const Value &);
+  Stmt *optimize(Stmt *);
+  // Statements that have to stay, removed ones are replaced by an empty
+  // block.
+  Stmt *optimizeBranch(Stmt *);
+  // Removes dead statements in place, the body shrinks.
+  std::span<Stmt *> optimize(std::span<Stmt *>);
+
+  void visitFnStmt(FnStmt *) override;
+  void visitVarStmt(VarStmt *) override;
+  void visitClassStmt(ClassStmt *) override;
+  void visitIfStmt(IfStmt *) override;
+  void visitWhileStmt(WhileStmt *) override;
+  void visitForStmt(ForStmt *) override;
+  void visitScopedStmt(ScopedStmt *) override;
+  void visitExprStmt(ExprStmt *) override;
+  void visitReturnStmt(ReturnStmt *) override;
+
+  Value visitBinaryExpr(BinaryExpr *) override;
+  Value visitBreakExpr(BreakExpr *) override;
+  Value visitContinueExpr(ContinueExpr *) override;
+  Value visitUnaryExpr(UnaryExpr *) override;
+  Value visitLiteralExpr(LiteralExpr *) override;
+  Value visitGroupExpr(GroupingExpr *) override;
+  Value visitSuperExpr(SuperExpr *) override;
+  Value visitThisExpr(ThisExpr *) override;
+  Value visitCallExpr(FnCallExpr *) override;
+  Value visitGetFieldExpr(GetFieldExpr *) override;
+  Value visitSetFieldExpr(SetFieldExpr *) override;
+  Value visitTernaryExpr(TernaryExpr *) override;
+  Value visitVarExpr(VariableExpr *) override;
+  Value visitAssignExpr(AssignExpr *) override;
+
+public:
+  Optimizer(const std::unordered_set<Symbol> *usedGlobals = nullptr)
+      : usedGlobals(usedGlobals), nodes(), result(nullptr),
+        replacement(nullptr) {}
+
+  void optimize(std::vector<Stmt *> &program);
+};
+
+#endif
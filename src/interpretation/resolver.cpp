@@ -1,8 +1,10 @@
 #include "resolver.hpp"
 #include "../AST-generation/syntax_error.hpp"
+
+#include <algorithm>
 #include <string_view>
 
-void Resolver::resolve(std::vector<std::unique_ptr<Stmt>> &stmts) {
+void Resolver::resolve(std::span<Stmt *> stmts) {
   for (auto &&stmt : stmts) {
     try {
       stmt->accept(this);
@@ -13,18 +15,19 @@ void Resolver::resolve(std::vector<std::unique_ptr<Stmt>> &stmts) {
   }
 }
 
-void Resolver::declare(const Token *name) {
+int Resolver::declare(const Token *name, bool *used) {
   if (scopes.empty()) {
-    return;
+    return -1;
   }
 
-  auto namestr = std::get<const char *>(name->lexeme);
-  std::map<std::string, VarState> &scope = scopes.back();
-  if (scope.contains(namestr)) {
+  auto &scope = scopes.back().variables;
+  if (scope.contains(name->symbol)) {
     throw SyntaxError(name, "Variable with this name already exists.");
   }
 
-  scope.insert(std::make_pair(namestr, VarState::Init));
+  int slot = scope.size();
+  scope.emplace(name->symbol, Variable{VarState::Init, slot, used});
+  return slot;
 }
 
 void Resolver::define(const Token *name) {
@@ -32,64 +35,119 @@ void Resolver::define(const Token *name) {
     return;
   }
 
-  scopes.back().insert_or_assign(std::get<const char *>(name->lexeme),
-                                 VarState::Ready);
+  auto &variables = scopes.back().variables;
+  variables.find(name->symbol)->second.state = VarState::Ready;
 }
 
-void Resolver::resolveLocal(Expr *expr, const Token *name) {
+void Resolver::resolveLocal(Symbol name, int &depth, int &slot,
+                            int &upvalue) {
   for (int i = scopes.size() - 1; i >= 0; i--) {
-    if (scopes[i].contains(std::get<const char *>(name->lexeme))) {
-      interpreter.resolve(expr, scopes.size() - 1 - i);
+    auto &variables = scopes[i].variables;
+    if (auto it = variables.find(name); it != variables.end()) {
+      if (it->second.used) {
+        *it->second.used = true;
+      }
+
+      if (static_cast<size_t>(i) >= functions.back().scopeBase) {
+        depth = scopes.size() - 1 - i;
+        slot = it->second.slot;
+      } else {
+        scopes[i].captured = true;
+        upvalue = resolveUpvalue(functions.size() - 1, i, it->second.slot);
+      }
       return;
     }
   }
+
+  usedGlobals.insert(name);
 }
 
-void Resolver::resolveLocal(Expr *expr, const std::string &name) {
-  for (int i = scopes.size() - 1; i >= 0; i--) {
-    if (scopes[i].contains(name)) {
-      interpreter.resolve(expr, scopes.size() - 1 - i);
-      return;
-    }
+// Adds the slot `slot` of `scopes[scope]` to the upvalues of `function` and
+// of every function between the two.
+int Resolver::resolveUpvalue(size_t function, size_t scope, int slot) {
+  FunctionScope &fn = functions[function];
+  UpvalueRef ref;
+
+  // Closures are created in the scope just before their own.
+  if (scope >= functions[function - 1].scopeBase) {
+    ref = {true, static_cast<int>(fn.scopeBase - 1 - scope), slot};
+  } else {
+    ref = {false, 0, resolveUpvalue(function - 1, scope, slot)};
+  }
+
+  auto &upvalues = fn.stmt->upvalues;
+  if (auto it = std::find(upvalues.begin(), upvalues.end(), ref);
+      it != upvalues.end()) {
+    return it - upvalues.begin();
   }
+
+  upvalues.push_back(ref);
+  return upvalues.size() - 1;
 }
 
 void Resolver::resolveFunction(FnStmt *fn, FunctionType::Type type) {
   FunctionType::Type enclosingFn = currentFn;
   currentFn = type;
 
+  functions.push_back({fn, scopes.size()});
   beginScope();
+  // Methods find their receiver in the first slot.
+  if (type == FunctionType::Method || type == FunctionType::Initializer) {
+    scopes.back().variables.insert(std::make_pair(
+        Symbol::thisName, Variable{VarState::Ready, 0, nullptr}));
+  }
   for (auto &&arg : fn->args) {
-    declare(arg.get());
-    define(arg.get());
+    declare(arg);
+    define(arg);
   }
 
   resolve(fn->body);
-  endScope();
+  fn->captured = scopes.back().captured;
+  fn->scopeSize = endScope();
+  functions.pop_back();
   currentFn = enclosingFn;
 }
 
+void Resolver::markTailCalls(Expr *expr) {
+  if (auto call = dynamic_cast<FnCallExpr *>(expr)) {
+    call->isTailCall = true;
+  } else if (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+    markTailCalls(group->expr);
+  } else if (auto ternary = dynamic_cast<TernaryExpr *>(expr)) {
+    markTailCalls(ternary->trueBranch);
+    markTailCalls(ternary->falseBranch);
+  }
+}
+
 void Resolver::visitFnStmt(FnStmt *fn) {
-  declare(fn->name.get());
-  define(fn->name.get());
+  fn->slot = declare(fn->name, &fn->used);
+  define(fn->name);
+
+  // Resolved once it's parsed, any global it names may be used.
+  if (fn->deferred) {
+    usedGlobals.insert(fn->deferred->names.begin(),
+                       fn->deferred->names.end());
+    return;
+  }
+
   resolveFunction(fn, FunctionType::Function);
 }
 
 void Resolver::visitVarStmt(VarStmt *var) {
-  declare(var->name.get());
+  var->slot = declare(var->name, &var->used);
   if (var->value) {
     var->value->accept(this);
   }
 
-  define(var->name.get());
+  define(var->name);
 }
 
 void Resolver::visitClassStmt(ClassStmt *clas) {
-  declare(clas->name.get());
-  define(clas->name.get());
+  clas->slot = declare(clas->name);
+  define(clas->name);
 
   if (clas->superclass &&
-      clas->superclass->variable->lexeme == clas->name->lexeme) {
+      clas->superclass->variable->symbol == clas->name->symbol) {
     throw SyntaxError(clas, "A class can't inherit from itself.");
   }
 
@@ -98,26 +156,21 @@ void Resolver::visitClassStmt(ClassStmt *clas) {
     clas->superclass->accept(this);
 
     beginScope();
-    scopes.back().insert(std::make_pair("super", VarState::Ready));
+    scopes.back().variables.insert(std::make_pair(
+        Symbol::superName, Variable{VarState::Ready, 0, nullptr}));
   } else {
     currentClass = ClassType::None;
   }
 
-  beginScope();
-  scopes.back().insert(std::make_pair("this", VarState::Ready));
-
   for (auto &&stmt : clas->body) {
-    auto method = dynamic_cast<FnStmt *>(stmt.get());
-    if (method && std::string_view(
-                      std::get<const char *>(method->name->lexeme)) == "init") {
+    auto method = dynamic_cast<FnStmt *>(stmt);
+    if (method && method->name->symbol == Symbol::initName) {
       resolveFunction(method, FunctionType::Initializer);
     } else {
-      resolveFunction(method, FunctionType::Function);
+      resolveFunction(method, FunctionType::Method);
     }
   }
 
-  endScope();
-
   if (clas->superclass) {
     endScope();
   }
@@ -140,19 +193,25 @@ void Resolver::visitWhileStmt(WhileStmt *loop) {
 
 void Resolver::visitForStmt(ForStmt *loop) {
   beginScope();
-  loop->initializer->accept(this);
+  if (loop->initializer) {
+    loop->initializer->accept(this);
+  }
   loop->condition->accept(this);
-  loop->increment->accept(this);
+  if (loop->increment) {
+    loop->increment->accept(this);
+  }
   loops++;
   loop->body->accept(this);
   loops--;
-  endScope();
+  loop->captured = scopes.back().captured;
+  loop->scopeSize = endScope();
 }
 
 void Resolver::visitScopedStmt(ScopedStmt *block) {
   beginScope();
   resolve(block->body);
-  endScope();
+  block->captured = scopes.back().captured;
+  block->scopeSize = endScope();
 }
 
 void Resolver::visitExprStmt(ExprStmt *stmt) { stmt->expr->accept(this); }
@@ -166,6 +225,7 @@ void Resolver::visitReturnStmt(ReturnStmt *ret) {
     }
 
     ret->value->accept(this);
+    markTailCalls(ret->value);
   }
 }
 
@@ -209,12 +269,14 @@ Value Resolver::visitSuperExpr(SuperExpr *expr) {
                       "Can't access 'super' in a class without superclass.");
   }
 
-  resolveLocal(expr, "super");
+  resolveLocal(Symbol::superName, expr->depth, expr->slot, expr->upvalue);
+  resolveLocal(Symbol::thisName, expr->thisDepth, expr->thisSlot,
+               expr->thisUpvalue);
   return nullptr;
 }
 
 Value Resolver::visitThisExpr(ThisExpr *expr) {
-  resolveLocal(expr, "this");
+  resolveLocal(Symbol::thisName, expr->depth, expr->slot, expr->upvalue);
   return nullptr;
 }
 
@@ -246,21 +308,23 @@ Value Resolver::visitTernaryExpr(TernaryExpr *expr) {
 }
 
 Value Resolver::visitVarExpr(VariableExpr *expr) {
-  if (!scopes.empty() &&
-      scopes.back().contains(std::get<const char *>(expr->variable->lexeme)) &&
-      scopes.back()
-              .find(std::get<const char *>(expr->variable->lexeme))
-              ->second != VarState::Ready) {
-    throw SyntaxError(expr, "You are trying to read the value of a variable "
-                            "that hasn't been defined yet.");
+  Symbol name = expr->variable->symbol;
+  if (!scopes.empty()) {
+    auto &variables = scopes.back().variables;
+    if (auto it = variables.find(name);
+        it != variables.end() && it->second.state != VarState::Ready) {
+      throw SyntaxError(expr, "You are trying to read the value of a variable "
+                              "that hasn't been defined yet.");
+    }
   }
 
-  resolveLocal(expr, expr->variable.get());
+  resolveLocal(name, expr->depth, expr->slot, expr->upvalue);
   return nullptr;
 }
 
 Value Resolver::visitAssignExpr(AssignExpr *expr) {
   expr->value->accept(this);
-  resolveLocal(expr, expr->variable.get());
+  resolveLocal(expr->variable->symbol, expr->depth, expr->slot,
+               expr->upvalue);
   return nullptr;
 }
@@ -2,18 +2,20 @@
 #define RESOLVER_H
 
 #include "../AST-generation/statements.hpp"
-#include "interpreter.hpp"
 #include "visitor.hpp"
 
-#include <map>
 #include <memory>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace FunctionType {
 enum Type {
   None,
   Function,
+  Method,
   Initializer,
 };
 }
@@ -31,27 +33,60 @@ enum VarState {
   Ready,
 };
 
+// `used` points at the flag of the declaration, set once the variable is
+// referenced. Parameters and receivers don't have one.
+struct Variable {
+  VarState state;
+  int slot;
+  bool *used;
+};
+
+struct Scope {
+  std::unordered_map<Symbol, Variable> variables;
+  // Set once a closure uses one of the variables.
+  bool captured;
+};
+
+// A function being resolved, its own scopes start at `scopes[scopeBase]`.
+// Top-level code is the function with a null `stmt`.
+struct FunctionScope {
+  FnStmt *stmt;
+  size_t scopeBase;
+};
+
+// Checks the static rules of the language and numbers every local variable,
+// storing the (depth, slot) pair of each access directly on the AST. Accesses
+// to a variable of an enclosing function go through an upvalue instead, so
+// functions only keep alive the variables they actually use.
 class Resolver : Statement::Visitor, Expression::Visitor {
 private:
-  Interpreter &interpreter;
   FunctionType::Type currentFn;
   ClassType::Type currentClass;
   int loops;
-  std::vector<std::map<std::string, VarState>> scopes;
+  std::vector<Scope> scopes;
+  std::vector<FunctionScope> functions;
 
 public:
   bool hadError;
+  // Names of the globals the program refers to, globals are looked up by
+  // name so any other one is never used.
+  std::unordered_set<Symbol> usedGlobals;
 
 private:
-  void beginScope() { scopes.emplace_back(std::map<std::string, VarState>()); }
-  void endScope() { scopes.pop_back(); }
+  void beginScope() { scopes.emplace_back(Scope{{}, false}); }
+  int endScope() {
+    int size = scopes.back().variables.size();
+    scopes.pop_back();
+    return size;
+  }
 
-  void declare(const Token *);
+  int declare(const Token *, bool *used = nullptr);
   void define(const Token *);
 
-  void resolveLocal(Expr *, const std::string &);
-  void resolveLocal(Expr *, const Token *);
+  void resolveLocal(Symbol, int &depth, int &slot, int &upvalue);
+  int resolveUpvalue(size_t function, size_t scope, int slot);
   void resolveFunction(FnStmt *, FunctionType::Type);
+  void markTailCalls(Expr *);
 
   void visitFnStmt(FnStmt *) override;
   void visitVarStmt(VarStmt *) override;
@@ -79,11 +114,11 @@ private:
   Value visitAssignExpr(AssignExpr *) override;
 
 public:
-  Resolver(Interpreter &interpreter)
-      : interpreter(interpreter), currentFn(FunctionType::None),
-        currentClass(ClassType::None), loops(0), scopes(), hadError(false) {}
+  Resolver()
+      : currentFn(FunctionType::None), currentClass(ClassType::None), loops(0),
+        scopes(), functions({{nullptr, 0}}), hadError(false), usedGlobals() {}
 
-  void resolve(std::vector<std::unique_ptr<Stmt>> &);
+  void resolve(std::span<Stmt *>);
 };
 
 #endif
@@ -16,15 +16,17 @@ public:
 public:
   RuntimeError(const Token *errToken, const std::string &msg)
       : line(errToken->line), column(errToken->column),
-        filename(errToken->filename), msg(msg) {}
+        filename(errToken->filename()), msg(msg) {}
 
   RuntimeError(Expr *errToken, const std::string &msg)
-      : line(errToken->line), column(errToken->column),
-        filename(errToken->file), msg(msg) {}
+      : RuntimeError(errToken->location, msg) {}
 
   RuntimeError(Stmt *errToken, const std::string &msg)
-      : line(errToken->line), column(errToken->column),
-        filename(errToken->filename), msg(msg) {}
+      : RuntimeError(errToken->location, msg) {}
+
+  RuntimeError(const SourceLocation &location, const std::string &msg)
+      : line(location.line), column(location.column),
+        filename(location.filename), msg(msg) {}
 
   std::string what();
 };
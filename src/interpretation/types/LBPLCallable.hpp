@@ -6,10 +6,31 @@
 
 class Interpreter;
 
-class LBPLCallable {
+namespace CallableType {
+enum Type {
+  Native,
+  Class,
+  Function,
+  Closure,
+  BoundMethod,
+};
+}
+
+class LBPLCallable : public LBPLObject {
+public:
+  const CallableType::Type type;
+
 public:
+  LBPLCallable(CallableType::Type type)
+      : LBPLObject(type == CallableType::Class ? ObjType::Class
+                                               : ObjType::Callable),
+        type(type) {}
+
   virtual int arity() = 0;
   virtual Value call(Interpreter*, std::vector<Value>&) = 0;
+
+  // Only methods get bound to a receiver, natives never end up in a class.
+  virtual LBPLCallable *bind(LBPLInstance *) { return nullptr; }
 };
 
 #endif
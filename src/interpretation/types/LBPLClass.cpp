@@ -1,22 +1,21 @@
 #include "LBPLClass.hpp"
+#include "../heap.hpp"
 #include "../interpreter.hpp"
 #include "LBPLInstance.hpp"
 
 Value LBPLClass::call(Interpreter *interpreter, std::vector<Value> &args) {
-  auto instance = std::make_shared<LBPLInstance>(this);
+  auto instance = heap.allocate<LBPLInstance>(this);
 
-  LBPLFunc *init = findMethod("init");
-  if (init) {
-    init->bind(instance);
-    init->call(interpreter, args);
+  if (auto init = findMethod(Symbol::initName)) {
+    init->bind(instance)->call(interpreter, args);
   }
 
   return instance;
 }
 
-LBPLFunc *LBPLClass::findMethod(const std::string &name) {
-  if (methods.contains(name)) {
-    return methods.find(name)->second;
+LBPLCallable *LBPLClass::findMethod(Symbol name) {
+  if (auto it = methods.find(name); it != methods.end()) {
+    return it->second;
   } else if (superclass) {
     return superclass->findMethod(name);
   }
@@ -24,7 +23,14 @@ LBPLFunc *LBPLClass::findMethod(const std::string &name) {
   return nullptr;
 }
 
+void LBPLClass::trace(Heap &heap) {
+  heap.markObject(superclass);
+  for (auto &&[name, method] : methods) {
+    heap.markObject(method);
+  }
+}
+
 int LBPLClass::arity() {
-  auto it = methods.find("init");
-  return it == methods.end() ? 0 : it->second->arity();
+  auto init = findMethod(Symbol::initName);
+  return init ? init->arity() : 0;
 }
@@ -3,27 +3,37 @@
 
 #include "LBPLCallable.hpp"
 #include "LBPLFunction.hpp"
+#include "LBPLShape.hpp"
 
-#include <map>
-#include <memory>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
 
 class LBPLClass : public LBPLCallable {
 public:
   std::string name;
-  std::shared_ptr<LBPLClass> superclass;
-  std::map<std::string, LBPLFunc *> methods;
+  LBPLClass *superclass;
+  std::unordered_map<Symbol, LBPLCallable *> methods;
+  // Shape of a new instance, and how many fields the largest instance seen
+  // so far has so that new ones allocate their fields only once.
+  Shape rootShape;
+  size_t instanceSize;
 
 public:
-  LBPLClass(const std::string &name, std::shared_ptr<LBPLClass> &superclass,
-            std::map<std::string, LBPLFunc *> &methods)
-      : name(name), superclass(superclass), methods(methods) {}
-  LBPLClass(const std::string &name, std::map<std::string, LBPLFunc *> &methods)
-      : name(name), superclass(nullptr), methods(methods) {}
+  LBPLClass(const std::string &name, LBPLClass *superclass,
+            std::unordered_map<Symbol, LBPLCallable *> &methods)
+      : LBPLCallable(CallableType::Class), name(name), superclass(superclass),
+        methods(methods), rootShape(), instanceSize(0) {}
+  LBPLClass(const std::string &name,
+            std::unordered_map<Symbol, LBPLCallable *> &methods)
+      : LBPLCallable(CallableType::Class), name(name), superclass(nullptr),
+        methods(methods), rootShape(), instanceSize(0) {}
 
-  LBPLFunc *findMethod(const std::string &);
+  LBPLCallable *findMethod(Symbol);
 
   int arity() override;
   Value call(Interpreter *, std::vector<Value> &) override;
+  void trace(Heap &) override;
 };
 
 #endif
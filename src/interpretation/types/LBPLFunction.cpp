@@ -1,30 +1,71 @@
 #include "LBPLFunction.hpp"
+#include "../heap.hpp"
 #include "../interpreter.hpp"
+#include "../lazy_functions.hpp"
+#include "LBPLInstance.hpp"
 
-void LBPLFunc::bind(std::shared_ptr<LBPLInstance> &&instance) {
-  closureEnv = std::make_shared<Environment>();
-  closureEnv->define("this", instance);
-}
-
-void LBPLFunc::bind(std::shared_ptr<LBPLInstance> &instance) {
-  closureEnv = std::make_shared<Environment>();
-  closureEnv->define("this", instance);
+LBPLCallable *LBPLFunc::bind(LBPLInstance *instance) {
+  auto method = heap.allocate<LBPLFunc>(stmt, isInitializer);
+  method->upvalues = upvalues;
+  method->receiver = instance;
+  return method;
 }
 
 int LBPLFunc::arity() { return stmt->args.size(); }
 
 Value LBPLFunc::call(Interpreter *interpreter, std::vector<Value> &args) {
-  auto env = std::make_shared<Environment>(closureEnv);
+  // Tail calls are run by this loop instead of recursing.
+  LBPLCallable *callee;
+  std::vector<Value> tailArgs;
+  LBPLFunc *fn = this;
+  std::vector<Value> *fnArgs = &args;
 
-  for (int i = 0; i < stmt->args.size(); i++) {
-    env->define(std::get<const char *>(stmt->args[i]->lexeme), args[i]);
-  }
+  // The caller may have been the only one holding the function.
+  interpreter->pushRoot(fn);
+  LBPLFunc *enclosing = interpreter->enterFunction(fn);
+  auto mark = interpreter->scopeMark();
+
+  while (true) {
+    // A tail call's arguments are already out of the frame it replaces.
+    interpreter->releaseScopes(mark);
+    if (fn->stmt->deferred) {
+      LazyFunctions::complete(fn->stmt);
+    }
+    auto env = interpreter->newEnvironment(fn->stmt->scopeSize, nullptr);
+
+    int first = 0;
+    if (fn->receiver) {
+      env->values[first++] = fn->receiver;
+    }
+    for (size_t i = 0; i < fn->stmt->args.size(); i++) {
+      env->values[first + i] = (*fnArgs)[i];
+    }
 
-  try {
-    interpreter->executeBlock(stmt->body, env);
-  } catch (ReturnException &ret) {
-    return isInitializer ? closureEnv->getAt(0, "this") : ret.value;
+    interpreter->executeBlock(fn->stmt->body, env);
+    if (fn->stmt->captured) {
+      interpreter->closeUpvalues(env);
+    }
+    if (!interpreter->consumeTailCall(callee, tailArgs)) {
+      break;
+    }
+
+    fn = static_cast<LBPLFunc *>(callee);
+    fnArgs = &tailArgs;
+    interpreter->popRoot();
+    interpreter->pushRoot(fn);
+    interpreter->enterFunction(fn);
   }
 
-  return isInitializer ? closureEnv->getAt(0, "this") : nullptr;
+  interpreter->releaseScopes(mark);
+  interpreter->enterFunction(enclosing);
+  interpreter->popRoot();
+  Value ret = interpreter->consumeReturn();
+  return fn->isInitializer ? fn->receiver : ret;
+}
+
+void LBPLFunc::trace(Heap &heap) {
+  for (auto &&upvalue : upvalues) {
+    heap.markObject(upvalue);
+  }
+  heap.markObject(receiver);
 }
@@ -2,30 +2,29 @@
 #define LBPL_FUNCTION_H
 
 #include "../../AST-generation/statements.hpp"
-#include "../environment.hpp"
 #include "LBPLCallable.hpp"
+#include "LBPLUpvalue.hpp"
 
-#include <memory>
+#include <vector>
 
 class LBPLFunc : public LBPLCallable {
-private:
+public:
   FnStmt *stmt;
-  std::shared_ptr<Environment> closureEnv;
+  std::vector<LBPLUpvalue *> upvalues;
+  // Set on methods bound to an instance, it goes in the first slot.
+  LBPLInstance *receiver;
   bool isInitializer;
 
 public:
-  LBPLFunc(FnStmt *stmt, std::shared_ptr<Environment> &closureEnv,
-           bool isInitializer)
-      : stmt(stmt), closureEnv(closureEnv), isInitializer(isInitializer) {}
-  LBPLFunc(FnStmt *stmt, std::shared_ptr<Environment> &&closureEnv,
-           bool isInitializer)
-      : stmt(stmt), closureEnv(closureEnv), isInitializer(isInitializer) {}
+  LBPLFunc(FnStmt *stmt, bool isInitializer)
+      : LBPLCallable(CallableType::Function), stmt(stmt), upvalues(),
+        receiver(nullptr), isInitializer(isInitializer) {}
 
-  void bind(std::shared_ptr<LBPLInstance> &&instance);
-  void bind(std::shared_ptr<LBPLInstance> &instance);
+  LBPLCallable *bind(LBPLInstance *instance) override;
 
   int arity() override;
   Value call(Interpreter *, std::vector<Value> &) override;
+  void trace(Heap &) override;
 };
 
 #endif
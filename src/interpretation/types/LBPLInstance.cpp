@@ -1,22 +1,53 @@
 #include "LBPLInstance.hpp"
-#include "../runtime_error.hpp"
-#include <string>
+#include "../heap.hpp"
 
-Value LBPLInstance::get(const Token *name) {
-  const char *lexeme = std::get<const char *>(name->lexeme);
-  if (fields.contains(lexeme)) {
-    return fields.find(lexeme)->second;
+#include <algorithm>
+
+InlineCache::Entry LBPLInstance::lookup(Symbol name, InlineCache &cache) {
+  if (auto entry = cache.find(shape->id)) {
+    return *entry;
   }
 
-  LBPLFunc *method = lbplClass->findMethod(lexeme);
-  if (method) {
-    method->bind(std::make_shared<LBPLInstance>(this));
-    return std::make_shared<LBPLFunc>(*method);
+  InlineCache::Entry entry = {shape->id, shape->lookup(name), nullptr,
+                              nullptr};
+  if (entry.slot < 0) {
+    entry.method = lbplClass->findMethod(name);
+    if (!entry.method) {
+      return entry;
+    }
   }
 
-  throw RuntimeError(name, "Undefined field '" + std::string(lexeme) + "'.");
+  cache.add(entry);
+  return entry;
 }
 
-void LBPLInstance::set(const Token *name, Value &value) {
-  fields.insert_or_assign(std::get<const char *>(name->lexeme), value);
+void LBPLInstance::store(Symbol name, Value value, InlineCache &cache) {
+  auto entry = cache.find(shape->id);
+  InlineCache::Entry added;
+
+  if (!entry) {
+    added = {shape->id, shape->lookup(name), nullptr, nullptr};
+    if (added.slot < 0) {
+      added.slot = fields.size();
+      added.transition = shape->addField(name);
+    }
+
+    cache.add(added);
+    entry = &added;
+  }
+
+  if (entry->transition) {
+    shape = entry->transition;
+    fields.push_back(value);
+    lbplClass->instanceSize = std::max(lbplClass->instanceSize, fields.size());
+  } else {
+    fields[entry->slot] = value;
+  }
+}
+
+void LBPLInstance::trace(Heap &heap) {
+  heap.markObject(lbplClass);
+  for (auto &&value : fields) {
+    heap.markValue(value);
+  }
 }
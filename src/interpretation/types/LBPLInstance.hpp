@@ -1,22 +1,36 @@
 #ifndef LBPL_INSTANCE_H
 #define LBPL_INSTANCE_H
 
+#include "../inline_cache.hpp"
 #include "LBPLClass.hpp"
+#include "LBPLShape.hpp"
 
-#include <map>
+#include <vector>
 
-class LBPLInstance {
-private:
+// Fields are stored in a flat array, `shape` tells which slot holds which
+// field.
+class LBPLInstance : public LBPLObject {
+public:
   LBPLClass *lbplClass;
-  std::map<std::string, Value> fields;
+  Shape *shape;
+  std::vector<Value> fields;
 
 public:
-  LBPLInstance(LBPLClass *lbplClass) : lbplClass(lbplClass), fields() {}
+  LBPLInstance(LBPLClass *lbplClass)
+      : LBPLObject(ObjType::Instance), lbplClass(lbplClass),
+        shape(&lbplClass->rootShape), fields() {
+    fields.reserve(lbplClass->instanceSize);
+  }
   LBPLInstance(LBPLInstance *other)
-      : lbplClass(other->lbplClass), fields(other->fields) {}
+      : LBPLObject(ObjType::Instance), lbplClass(other->lbplClass),
+        shape(other->shape), fields(other->fields) {}
+
+  // Finds the field or, failing that, the method `name`. An entry with
+  // neither a slot nor a method means the instance has no such property.
+  InlineCache::Entry lookup(Symbol name, InlineCache &);
+  void store(Symbol name, Value value, InlineCache &);
 
-  Value get(const Token *name);
-  void set(const Token *name, Value &value);
+  void trace(Heap &) override;
 };
 
 #endif
@@ -0,0 +1,15 @@
+#include "LBPLShape.hpp"
+
+uint32_t Shape::nextId = 0;
+
+Shape *Shape::addField(Symbol name) {
+  if (auto it = transitions.find(name); it != transitions.end()) {
+    return it->second.get();
+  }
+
+  auto shape = std::make_unique<Shape>();
+  shape->slots = slots;
+  shape->slots.emplace(name, slots.size());
+
+  return transitions.emplace(name, std::move(shape)).first->second.get();
+}
@@ -0,0 +1,43 @@
+#ifndef LBPL_SHAPE_H
+#define LBPL_SHAPE_H
+
+#include "../../AST-generation/tokens/symbol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// The layout of an instance: which slot of `LBPLInstance::fields` holds each
+// of its fields. Every class owns a tree of shapes, instances start from the
+// root and follow a transition each time a new field is added. Instances that
+// get the same fields in the same order, usually in `init`, end up sharing a
+// shape.
+class Shape {
+public:
+  // Unique for the whole run, caches key on it rather than on the address of
+  // a shape that could be freed along with its class and reused.
+  const uint32_t id;
+
+private:
+  static uint32_t nextId;
+
+  std::unordered_map<Symbol, uint32_t> slots;
+  std::unordered_map<Symbol, std::unique_ptr<Shape>> transitions;
+
+public:
+  Shape() : id(nextId++), slots(), transitions() {}
+  Shape(const Shape &) = delete;
+
+  // The slot of `name`, -1 if instances with this shape don't have it.
+  inline int lookup(Symbol name) const {
+    auto it = slots.find(name);
+    return it != slots.end() ? static_cast<int>(it->second) : -1;
+  }
+  inline size_t slotCount() const { return slots.size(); }
+
+  // The shape of an instance of this shape after adding `name` to it.
+  Shape *addField(Symbol name);
+};
+
+#endif
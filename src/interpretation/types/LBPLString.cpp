@@ -0,0 +1,49 @@
+#include "LBPLString.hpp"
+#include "../heap.hpp"
+
+#include <vector>
+
+LBPLString *LBPLString::concatenate(LBPLString *left, LBPLString *right) {
+  if (left->length + right->length < SHORT_LENGTH) {
+    return heap.allocate<LBPLString>(left->str() + right->str());
+  }
+
+  // A short piece appended to a rope is merged into its last half, instead
+  // of adding a node for each piece.
+  if (left->left && !left->right->left &&
+      left->right->length + right->length < SHORT_LENGTH) {
+    auto last = heap.allocate<LBPLString>(left->right->text + right->str());
+    return heap.allocate<LBPLString>(left->left, last);
+  }
+
+  return heap.allocate<LBPLString>(left, right);
+}
+
+// Ropes built in a loop are as deep as the number of pieces, they're walked
+// with a stack of their own.
+void LBPLString::flatten() {
+  std::string flat;
+  flat.reserve(length);
+
+  std::vector<LBPLString *> pending = {this};
+  while (!pending.empty()) {
+    LBPLString *string = pending.back();
+    pending.pop_back();
+
+    if (string->left) {
+      pending.push_back(string->right);
+      pending.push_back(string->left);
+    } else {
+      flat += string->text;
+    }
+  }
+
+  text = std::move(flat);
+  left = right = nullptr;
+  heap.resize(this, sizeof(LBPLString) + text.capacity());
+}
+
+void LBPLString::trace(Heap &heap) {
+  heap.markObject(left);
+  heap.markObject(right);
+}
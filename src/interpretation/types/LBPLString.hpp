@@ -0,0 +1,60 @@
+#ifndef LBPL_STRING_H
+#define LBPL_STRING_H
+
+#include "LBPLTypes.hpp"
+
+#include <cstddef>
+#include <string>
+
+// An immutable string. Concatenating long strings makes a rope that only
+// points to its two halves, the text is copied into it once something reads
+// it. Building a string piece by piece is then linear instead of copying
+// everything built so far at each step.
+class LBPLString : public LBPLObject {
+private:
+  // Below this many bytes strings are concatenated by copying them.
+  static constexpr size_t SHORT_LENGTH = 256;
+
+  // Empty while the string is a rope.
+  std::string text;
+  // The halves of a rope, null once the string is flat.
+  LBPLString *left, *right;
+  size_t length;
+
+  void flatten();
+
+public:
+  LBPLString(const std::string &str)
+      : LBPLObject(ObjType::String), text(str), left(nullptr), right(nullptr),
+        length(text.size()) {}
+  LBPLString(std::string &&str)
+      : LBPLObject(ObjType::String), text(std::move(str)), left(nullptr),
+        right(nullptr), length(text.size()) {}
+  LBPLString(LBPLString *left, LBPLString *right)
+      : LBPLObject(ObjType::String), text(), left(left), right(right),
+        length(left->length + right->length) {}
+
+  static LBPLString *concatenate(LBPLString *left, LBPLString *right);
+
+  // Flattens a rope.
+  inline const std::string &str() {
+    if (left) {
+      flatten();
+    }
+    return text;
+  }
+  inline size_t capacity() const { return text.capacity(); }
+
+  void trace(Heap &) override;
+};
+
+// Appends to a buffer of its own, a string is only made when it's asked for.
+class LBPLStringBuilder : public LBPLObject {
+public:
+  std::string buffer;
+
+public:
+  LBPLStringBuilder() : LBPLObject(ObjType::StringBuilder), buffer() {}
+};
+
+#endif
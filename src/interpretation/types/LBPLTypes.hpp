@@ -1,16 +1,121 @@
 #ifndef LBPL_TYPES_H
 #define LBPL_TYPES_H
 
-#include <memory>
-#include <string>
-#include <variant>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
+class Heap;
+class LBPLString;
 class LBPLInstance;
 class LBPLCallable;
 class LBPLClass;
 
-using Value =
-    std::variant<std::string, int, double, bool, char, std::nullptr_t,
-                 std::shared_ptr<LBPLClass>, std::shared_ptr<LBPLInstance>,
-                 std::shared_ptr<LBPLCallable>>;
+namespace ObjType {
+enum Type {
+  String,
+  Instance,
+  Class,
+  Callable,
+  StringBuilder,
+  // Never stored in a `Value`, only referenced by closures.
+  Upvalue,
+};
+}
+
+// Header shared by everything that lives on the heap, objects are chained
+// together so that the collector can sweep the ones it didn't mark.
+class LBPLObject {
+public:
+  const ObjType::Type objType;
+  bool marked;
+  size_t size;
+  LBPLObject *nextObject;
+
+public:
+  LBPLObject(ObjType::Type objType)
+      : objType(objType), marked(false), size(0), nextObject(nullptr) {}
+  virtual ~LBPLObject() {}
+
+  // Marks every object directly reachable from this one.
+  virtual void trace(Heap &) {}
+};
+
+// A NaN-boxed value. Doubles are stored as they are, every other type hides
+// in the payload of a quiet NaN:
+//
+//   - objects set the sign bit and keep their 48-bit pointer in the low bits,
+//   - ints and chars use bits 48-49 as a tag and the low bits as payload,
+//   - nil, false and true are the tag-less NaNs 1, 2 and 3.
+class Value {
+private:
+  static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+  static constexpr uint64_t QNAN = 0x7ffc000000000000;
+  static constexpr uint64_t TAG_MASK = QNAN | SIGN_BIT | (3ull << 48);
+
+  static constexpr uint64_t TAG_INT = QNAN | (1ull << 48);
+  static constexpr uint64_t TAG_CHAR = QNAN | (2ull << 48);
+  static constexpr uint64_t VAL_NIL = QNAN | 1;
+  static constexpr uint64_t VAL_FALSE = QNAN | 2;
+  static constexpr uint64_t VAL_TRUE = QNAN | 3;
+
+  uint64_t bits;
+
+public:
+  constexpr Value() : bits(VAL_NIL) {}
+  constexpr Value(std::nullptr_t) : bits(VAL_NIL) {}
+  // Only real bools, a pointer to an object that is just forward declared
+  // would otherwise silently convert to one.
+  template <typename T>
+    requires std::same_as<T, bool>
+  constexpr Value(T b) : bits(b ? VAL_TRUE : VAL_FALSE) {}
+  constexpr Value(int i) : bits(TAG_INT | static_cast<uint32_t>(i)) {}
+  constexpr Value(char c) : bits(TAG_CHAR | static_cast<uint8_t>(c)) {}
+  Value(double d) { std::memcpy(&bits, &d, sizeof(double)); }
+  Value(LBPLObject *obj)
+      : bits(SIGN_BIT | QNAN | reinterpret_cast<uintptr_t>(obj)) {}
+
+  inline bool isNil() const { return bits == VAL_NIL; }
+  inline bool isBool() const { return (bits | 1) == VAL_TRUE; }
+  inline bool isInt() const { return (bits & TAG_MASK) == TAG_INT; }
+  inline bool isChar() const { return (bits & TAG_MASK) == TAG_CHAR; }
+  inline bool isDouble() const { return (bits & QNAN) != QNAN; }
+  inline bool isObj() const {
+    return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN);
+  }
+  inline bool isObjType(ObjType::Type type) const {
+    return isObj() && asObj()->objType == type;
+  }
+  inline bool isString() const { return isObjType(ObjType::String); }
+  inline bool isInstance() const { return isObjType(ObjType::Instance); }
+  inline bool isClass() const { return isObjType(ObjType::Class); }
+  inline bool isCallable() const { return isObjType(ObjType::Callable); }
+
+  inline bool asBool() const { return bits == VAL_TRUE; }
+  inline int asInt() const { return static_cast<int32_t>(bits); }
+  inline char asChar() const { return static_cast<char>(bits); }
+  inline double asDouble() const {
+    double d;
+    std::memcpy(&d, &bits, sizeof(double));
+    return d;
+  }
+  inline LBPLObject *asObj() const {
+    return reinterpret_cast<LBPLObject *>(bits & ~(SIGN_BIT | QNAN));
+  }
+  // Same bits, i.e. same number or same object. Not the language's `==`.
+  inline bool operator==(const Value &other) const {
+    return bits == other.bits;
+  }
+
+  // Unchecked, callers test the type with one of the `is*` methods first.
+  template <typename T> inline T *as() const {
+    return static_cast<T *>(asObj());
+  }
+};
+
+static_assert(sizeof(Value) == 8);
+static_assert(std::is_trivially_copyable_v<Value>);
+
 #endif
@@ -0,0 +1,4 @@
+#include "LBPLUpvalue.hpp"
+#include "../heap.hpp"
+
+void LBPLUpvalue::trace(Heap &heap) { heap.markValue(closed); }
@@ -0,0 +1,24 @@
+#ifndef LBPL_UPVALUE_H
+#define LBPL_UPVALUE_H
+
+#include "LBPLTypes.hpp"
+
+// A variable captured by a closure. While the variable's slot is still alive,
+// on the VM stack or in an interpreter environment, `location` points to it.
+// Once the slot goes out of scope the value is moved into `closed` and
+// `location` points there instead.
+class LBPLUpvalue : public LBPLObject {
+public:
+  Value *location;
+  Value closed;
+  LBPLUpvalue *next;
+
+public:
+  LBPLUpvalue(Value *location)
+      : LBPLObject(ObjType::Upvalue), location(location), closed(nullptr),
+        next(nullptr) {}
+
+  void trace(Heap &) override;
+};
+
+#endif
@@ -1,35 +1,224 @@
-#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 
+#include "AST-generation/ast_printer.hpp"
+#include "AST-generation/lexer.hpp"
 #include "AST-generation/parser.hpp"
+#include "AST-generation/scan.hpp"
+#include "bytecode/compiler.hpp"
+#include "bytecode/module_cache.hpp"
+#include "bytecode/vm.hpp"
+#include "interpretation/heap.hpp"
 #include "interpretation/interpreter.hpp"
+#include "interpretation/optimizer.hpp"
 #include "interpretation/resolver.hpp"
 
+// Walks `[p, end)` the way the lexer does, but only through the scanning
+// kernels: how fast the file would lex if making tokens were free.
+static size_t scanOnly(const char *p, const char *end) {
+  size_t runs = 0;
+  while (p < end) {
+    if (Lexer::isAlpha(*p)) {
+      p = Scan::kernels->identifier(p, end);
+    } else if (Lexer::isDigit(*p)) {
+      p = Scan::kernels->digits(p, end);
+    } else if (*p == ' ') {
+      p = Scan::kernels->spaces(p, end);
+    } else if (*p == '#') {
+      p = Scan::kernels->line(p, end);
+    } else if (*p == '"') {
+      // Along with the closing quote.
+      p = Scan::kernels->string(p + 1, end);
+      if (p < end) {
+        p++;
+      }
+    } else {
+      p++;
+      continue;
+    }
+    runs++;
+  }
+
+  return runs;
+}
+
+// Lexes `script` with every set of scanning kernels the CPU supports and
+// prints the best throughput of a few runs for each, along with how fast the
+// kernels alone go through it.
+static int lexBenchmark(const char *script) {
+  for (const Scan::Kernels *kernels : Scan::available()) {
+    Scan::kernels = kernels;
+    double best = 0, bestScan = 0;
+    size_t bytes = 0, tokens = 0;
+
+    for (int run = 0; run < 5; run++) {
+      Lexer::Source file(script);
+      if (!file.loaded) {
+        std::cerr << "I/O error: couldn't load file `" << script << "`.";
+        return -1;
+      }
+
+      bytes = file.end - file.current;
+      auto start = std::chrono::steady_clock::now();
+      volatile size_t runs = scanOnly(file.current, file.end);
+      (void)runs;
+      auto scanned = std::chrono::steady_clock::now();
+      while (Lexer::getNextToken(file)->type != TokenType::Eof) {
+      }
+      auto lexed = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> scanTime = scanned - start;
+      std::chrono::duration<double> lexTime = lexed - scanned;
+      bestScan = std::max(bestScan, bytes / scanTime.count() / (1024 * 1024));
+      best = std::max(best, bytes / lexTime.count() / (1024 * 1024));
+      tokens = file.tokens.size();
+    }
+
+    std::cout << kernels->name << ": " << best << " MB/s, " << tokens
+              << " tokens (kernels alone: " << bestScan << " MB/s)"
+              << std::endl;
+  }
+
+  return 0;
+}
+
+static int run(VM &vm, std::shared_ptr<FnPrototype> &program,
+               bool cacheStats) {
+  vm.interpret(program);
+  if (cacheStats) {
+    printCacheSites(std::cerr, vm.getCacheSites());
+  }
+  return 0;
+}
+
 int main(const int argc, const char **argv) {
-  if (argc < 2) {
-    std::cerr << "\033[1;31mNot enough arguemnts.\tUsage: lbpl [script]"
+  const char *script = nullptr;
+  bool treeWalk = false;
+  bool cacheStats = false;
+  bool lexBench = false;
+  bool useCache = true;
+  bool dumpAst = false;
+  bool eager = false;
+  const char *badArgument = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg(argv[i]);
+
+    if (arg == "--tree-walk") {
+      treeWalk = true;
+    } else if (arg == "--ic-stats") {
+      cacheStats = true;
+    } else if (arg == "--no-cache") {
+      useCache = false;
+    } else if (arg == "--dump-ast") {
+      dumpAst = true;
+    } else if (arg == "--eager") {
+      eager = true;
+    } else if (arg == "--lex-bench") {
+      lexBench = true;
+    } else if (arg.starts_with("--gc-growth=")) {
+      std::string_view value = arg.substr(12);
+      double factor = 0;
+      auto [end, error] =
+          std::from_chars(value.data(), value.data() + value.size(), factor);
+
+      // A factor below 1 would collect before the heap has grown at all.
+      if (error != std::errc() || end != value.data() + value.size() ||
+          !std::isfinite(factor) || factor < 1) {
+        badArgument = argv[i];
+      } else {
+        heap.growthFactor = factor;
+      }
+    } else {
+      script = argv[i];
+    }
+  }
+
+  if (!script || badArgument) {
+    if (badArgument) {
+      std::cerr << "\033[1;31mInvalid argument `" << badArgument << "`.";
+    } else {
+      std::cerr << "\033[1;31mNot enough arguemnts.";
+    }
+    std::cerr << "\tUsage: lbpl [--tree-walk] "
+                 "[--gc-growth=<factor>] [--ic-stats] [--no-cache] "
+                 "[--dump-ast] [--eager] [--lex-bench] [script]"
               << std::endl;
     return -1;
   }
 
-  std::ifstream file(argv[1]);
-  if (!file.good()) {
-    std::cerr << "I/O error: couldn't load file `" << argv[1] << "`.";
+  if (lexBench) {
+    return lexBenchmark(script);
+  }
+
+  // A cached program skips lexing, parsing, resolving and compiling. It may
+  // have been built from skimmed bodies, so --eager always parses.
+  std::optional<VM> vm;
+  if (!treeWalk && !dumpAst) {
+    vm.emplace();
+
+    if (useCache && !eager) {
+      if (std::shared_ptr<FnPrototype> program =
+              ModuleCache::load(script, *vm)) {
+        return run(*vm, program, cacheStats);
+      }
+    }
+  }
+
+  // The dump shows every function, the bodies skimmed otherwise are only
+  // parsed once they're called.
+  Parser parser(script, !eager && !dumpAst);
+  if (!parser.loaded()) {
+    std::cerr << "I/O error: couldn't load file `" << script << "`.";
     return -1;
   }
 
-  Parser parser(file, argv[1]);
-  std::vector<std::unique_ptr<Stmt>> statements = parser.parse();
+  std::vector<Stmt *> statements = parser.parse();
 
   if (!parser.hadError) {
-    Interpreter interpreter;
-    Resolver resolver(interpreter);
+    Resolver resolver;
     resolver.resolve(statements);
 
-    if (!resolver.hadError) {
+    if (resolver.hadError) {
+      return -1;
+    }
+
+    Optimizer optimizer(&resolver.usedGlobals);
+    optimizer.optimize(statements);
+
+    if (dumpAst) {
+      AstPrinter(std::cout).print(statements);
+      return 0;
+    }
+
+    // The tree-walking interpreter is kept as the reference implementation
+    // of the language, the VM is what actually runs scripts.
+    if (treeWalk) {
+      Interpreter interpreter;
       interpreter.interpret(statements);
+      if (cacheStats) {
+        printCacheSites(std::cerr, interpreter.getCacheSites());
+      }
       return 0;
     }
+
+    Compiler compiler(*vm);
+    std::shared_ptr<FnPrototype> program = compiler.compile(statements);
+
+    if (!compiler.hadError) {
+      if (useCache) {
+        std::vector<const char *> files;
+        parser.files(files);
+        ModuleCache::store(script, files, *program, *vm);
+      }
+      return run(*vm, program, cacheStats);
+    }
   }
 
   return -1;
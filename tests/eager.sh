@@ -0,0 +1,19 @@
+#!/bin/sh
+# Checks that --eager reports a syntax error in a function that's never
+# called, even once a cached copy of the script exists.
+# Usage: tests/eager.sh path/to/lbpl
+set -e
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+script="$dir/eager.lbpl"
+printf 'fn broken() { let x = ; }\nprintln("ok");\n' >"$script"
+
+# Skims `broken`, runs and writes the cache.
+"$1" "$script" >/dev/null
+
+if "$1" --eager "$script" >/dev/null 2>&1; then
+  echo "--eager ran a script with a syntax error."
+  exit 1
+fi
+echo "--eager reports the syntax error."
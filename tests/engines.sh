@@ -0,0 +1,14 @@
+#!/bin/sh
+# Runs tests/engines.lbpl on the VM and on the tree-walking interpreter and
+# fails when their outputs differ.
+# Usage: tests/engines.sh path/to/lbpl
+set -e
+
+script="$(dirname "$0")/engines.lbpl"
+vm=$(mktemp)
+tree=$(mktemp)
+trap 'rm -f "$vm" "$tree"' EXIT
+
+"$1" --no-cache "$script" >"$vm"
+"$1" --tree-walk "$script" >"$tree"
+diff -u "$vm" "$tree" && echo "Both engines agree."